@@ -2,11 +2,15 @@
 #include <vector>
 #include <cassert>
 #include <mutex>
+#include <fstream>
+#include <string>
 #include <Eigen/Dense>
 #include "core/Platform.h"
 #include "core/Problem.h"
+#include "core/McsLock.h"
 #include "core/SpinLock.h"
 #include "environments/LocalAsyncScheduler.h"
+#include "environments/LocalMatchingScheduler.h"
 #include "environments/NetConfig.h"
 #include "environments/PairSelectionFunc.h"
 #include "problems/SepSmoothObjectiveProblem.h"
@@ -60,6 +64,8 @@ OptOutput quickTest(const Test &test) {
 	typedef RCDLocalScheduler<SepSmoothObjInfoSpec> Scheduler;
 	typedef LocalAsyncScheduler<SepSmoothObjInfoSpec, SpinLock> SpinAsyncScheduler;
 	typedef LocalAsyncScheduler<SepSmoothObjInfoSpec> LockFreeScheduler;
+	typedef LocalMatchingScheduler<SepSmoothObjInfoSpec> MatchingScheduler;
+	typedef LocalAsyncScheduler<SepSmoothObjInfoSpec, McsLock> McsAsyncScheduler;
  
 	int start, end, chunk;
 	Platform::getProcessRange(test.numVars, start, end, chunk);
@@ -98,14 +104,49 @@ OptOutput quickTest(const Test &test) {
 
 	RandomKPairs kpairs(&config, Platform::getNumLocalThreads(), 0);
 	CoveringPairs cover(&config, 0);
-	PairSelectionFactory factory = [config] (int threadId, int numThreads) -> PairSelection * {
-		OfflinePairs *p = new OfflinePairs();
-		RandomSinglePair base(&config, threadId);
-		p->init(&base, 2000000); //TODO: Remove hardcoded number
-		return p;
+
+	//Specify functions
+	SepSmoothObjectiveProblem problem = 
+		createQuadFunctions(test.numVars, test.varDim, start, end); 
+
+	PairSelectionFactory baseFactory = [config] (int threadId, int numThreads) -> PairSelection * {
+		return new RandomSinglePair(&config, threadId);
 	};
 
-	int numRecords = 0;
+	if(test.sampling == SAMPLING_LIPSCHITZ) {
+		vector<double> weights(test.numVars, 0.0);
+		for(int i = start; i < end; i++) {weights[i] = problem.function(i).L;}
+
+		std::shared_ptr<const AliasTable> table = WeightedPairs::createTable(weights, &config);
+		baseFactory = [config, table] (int threadId, int numThreads) -> PairSelection * {
+			return new WeightedPairs(table, &config, threadId);
+		};
+	}
+
+	//Pairs are pre-generated (and optionally saved to / replayed from
+	//"<pairsFile>.<threadId>"), or streamed if numRecords is 0.
+	int numRecords = test.numRecords;
+	int numVars = test.numVars;
+	std::string pairsFile = test.pairsFile ? test.pairsFile : "";
+	PairSelectionFactory factory = [baseFactory, numRecords, numVars, pairsFile] (int threadId, int numThreads) -> PairSelection * {
+		std::unique_ptr<PairSelection> base(baseFactory(threadId, numThreads));
+		if(numRecords <= 0) {return new StreamingPairs(base.release());}
+
+		std::unique_ptr<OfflinePairs> p(new OfflinePairs());
+		std::string fileName = pairsFile + "." + std::to_string(threadId);
+
+		if(!pairsFile.empty() && std::ifstream(fileName.c_str())) {
+			p->load(fileName.c_str(), numVars);
+			if(p->getNumRecords() != numRecords) {
+				throw FileFormatException(fileName + " holds a different number of records");
+			}
+		} else {
+			p->init(base.get(), numRecords, numVars);
+			if(!pairsFile.empty()) {p->save(fileName.c_str());}
+		}
+
+		return p.release();
+	};
 
 	switch(test.schedule) {
 	case SCHED_SPIN_DOUBLE:
@@ -114,6 +155,12 @@ OptOutput quickTest(const Test &test) {
 		static_cast<SpinAsyncScheduler *>(rcd)->setLockingLevel(LockFreeScheduler::DOUBLE);
 		break;
 
+	case SCHED_MCS_DOUBLE:
+		rcd = new McsAsyncScheduler(factory);
+		if(test.syncPeriod > 0) {static_cast<McsAsyncScheduler *>(rcd)->setSyncPeriod(test.syncPeriod);}
+		static_cast<McsAsyncScheduler *>(rcd)->setLockingLevel(McsAsyncScheduler::DOUBLE);
+		break;
+
 	case SCHED_SPIN_SINGLE:
 		rcd = new SpinAsyncScheduler(factory);
 		if(test.syncPeriod > 0) {static_cast<SpinAsyncScheduler *>(rcd)->setSyncPeriod(test.syncPeriod);}
@@ -124,16 +171,23 @@ OptOutput quickTest(const Test &test) {
 		static_cast<LockFreeScheduler *>(rcd)->setLockingLevel(LockFreeScheduler::LOCK_FREE);
 	if(test.syncPeriod > 0) {static_cast<LockFreeScheduler *>(rcd)->setSyncPeriod(test.syncPeriod);}
 		break;
+
+	case SCHED_OPTIMISTIC:
+		rcd = new LockFreeScheduler(factory);
+		static_cast<LockFreeScheduler *>(rcd)->setLockingLevel(LockFreeScheduler::OPTIMISTIC);
+		if(test.syncPeriod > 0) {static_cast<LockFreeScheduler *>(rcd)->setSyncPeriod(test.syncPeriod);}
+		break;
+
+	case SCHED_MATCHING:
+		rcd = new MatchingScheduler(&config);
+		if(test.syncPeriod > 0) {static_cast<MatchingScheduler *>(rcd)->setSyncPeriod(test.syncPeriod);}
+		break;
 	}
 
 	rcd->setMaxIterations(test.maxIterations);
 	//rcd->setStoppingCondition(test.stopping);
 	if(test.eps > 0) { rcd->setObjTolerance(test.eps); }
 
-	//Specify functions
-	SepSmoothObjectiveProblem problem = 
-		createQuadFunctions(test.numVars, test.varDim, start, end); 
-
 	//Specify constraints
 	vector<MatrixXd> A;
 
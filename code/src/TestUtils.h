@@ -23,7 +23,15 @@ enum ConstraintType {
 enum ScheduleType {
 	SCHED_SPIN_DOUBLE = 0,
 	SCHED_SPIN_SINGLE = 1,
-	SCHED_LOCK_FREE = 2
+	SCHED_LOCK_FREE = 2,
+	SCHED_MATCHING = 3,	//Bulk-synchronous rounds of disjoint pairs
+	SCHED_OPTIMISTIC = 4,
+	SCHED_MCS_DOUBLE = 5	//As SCHED_SPIN_DOUBLE with MCS queue locks
+};
+
+enum SamplingType {
+	SAMPLING_UNIFORM = 0,
+	SAMPLING_LIPSCHITZ = 1	//Pairs drawn in proportion to the nodes' L
 };
 
 struct Test {
@@ -31,7 +39,9 @@ struct Test {
 	: condition(0.0), maxIterations(100000)
 	, constraint(CONS_RANDOM_NONNEG) 
 	, schedule(SCHED_SPIN_DOUBLE), eps(-1)
-	, syncPeriod(-1), stopping(CHANGE) {}
+	, syncPeriod(-1), stopping(CHANGE)
+	, sampling(SAMPLING_UNIFORM)
+	, numRecords(2000000), pairsFile(0) {}
 
 	int numVars;
 	int varDim;
@@ -45,6 +55,9 @@ struct Test {
 	double eps;
 	int syncPeriod;
 	StoppingCondition stopping;
+	SamplingType sampling;
+	int numRecords;	//Pre-generated pair records per thread, 0 to stream them
+	const char *pairsFile;	//Pair traces are replayed from this prefix if present, saved otherwise
 };
 
 SepSmoothObjectiveProblem createQuadFunctions(int numVars, int varDim, int start, int end);
@@ -0,0 +1,42 @@
+#include "core/ActiveSet.h"
+
+ActiveSet::ActiveSet(int numVars, int patience)
+	: numVars_(numVars), patience_(patience), stuckCount_(new std::atomic<int>[numVars]),
+	  isActive_(numVars, 1) {
+	active_.reserve(numVars);
+	for(int i = 0; i < numVars; ++i) {
+		stuckCount_[i].store(0, std::memory_order_relaxed);
+		active_.push_back(i);
+	}
+}
+
+void ActiveSet::compact(const std::function<bool(int)> &canShrink) {
+	std::vector<int> kept;
+	kept.reserve(active_.size());
+
+	for(int id : active_) {
+		if(stuckCount_[id].load(std::memory_order_relaxed) < patience_
+		   || (canShrink && !canShrink(id))) {
+			kept.push_back(id);
+		}
+	}
+
+	if(kept.size() < 2) {return;}
+
+	for(int id : active_) {isActive_[id] = 0;}
+	for(int id : kept) {isActive_[id] = 1;}
+	active_.swap(kept);
+}
+
+bool ActiveSet::restoreAll() {
+	bool shrunk = size() < numVars_;
+
+	active_.clear();
+	for(int i = 0; i < numVars_; ++i) {
+		stuckCount_[i].store(0, std::memory_order_relaxed);
+		isActive_[i] = 1;
+		active_.push_back(i);
+	}
+
+	return shrunk;
+}
@@ -0,0 +1,60 @@
+#ifndef _RCD_ACTIVESET_H_
+#define _RCD_ACTIVESET_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * Shrinking heuristic for box-constrained problems.
+ * Update clients report, for every variable they update, whether the update
+ * left it at a bound without changing it. Variables that are stuck in this
+ * way for "patience" consecutive updates are dropped from the active list
+ * at the next compaction (if the problem agrees, see compact), and pair
+ * selectors (see ActiveSetPairs) stop sampling them.
+ *
+ * record() may be called concurrently. compact() and restoreAll() must be
+ * called when no selector or update client is running.
+ */
+class ActiveSet {
+public:
+	ActiveSet(int numVars, int patience);
+
+	void record(int varId, bool stuck) {
+		std::atomic<int> &count = stuckCount_[varId];
+		int old = count.load(std::memory_order_relaxed);
+
+		if(stuck) {
+			if(old < patience_) {count.store(old + 1, std::memory_order_relaxed);}
+		} else if(old != 0) {
+			count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Removes stuck variables for which canShrink (if given) returns true from
+	 * the active list. At least two variables are kept active.
+	 */
+	void compact(const std::function<bool(int)> &canShrink = nullptr);
+
+	/**
+	Makes all variables active again and clears the stuck counters.
+	Returns true if any variable was inactive.
+	*/
+	bool restoreAll();
+
+	int numVars() const {return numVars_;}
+	int size() const {return static_cast<int>(active_.size());}
+	int operator[](int k) const {return active_[k];}
+	bool isActive(int varId) const {return isActive_[varId] != 0;}
+
+private:
+	int numVars_;
+	int patience_;
+	std::unique_ptr<std::atomic<int>[]> stuckCount_;
+	std::vector<int> active_;
+	std::vector<char> isActive_;
+};
+
+#endif
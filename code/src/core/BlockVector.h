@@ -0,0 +1,59 @@
+#ifndef _RCD_BLOCKVECTOR_H_
+#define _RCD_BLOCKVECTOR_H_
+
+#include <Eigen/Core>
+
+/**
+ * Stores a set of equally sized blocks (e.g. the variables of a problem)
+ * in one contiguous, aligned buffer. Block i occupies entries
+ * [i * blockDim, (i+1) * blockDim) and is accessed through an Eigen::Map,
+ * so code written against vectors keeps working while scans over all blocks
+ * stream through memory.
+ */
+class BlockVector {
+public:
+	typedef Eigen::Map<Eigen::VectorXd> Block;
+	typedef Eigen::Map<const Eigen::VectorXd> ConstBlock;
+
+	BlockVector()
+		: numBlocks_(0), blockDim_(0) {}
+
+	BlockVector(int numBlocks, int blockDim) {
+		resize(numBlocks, blockDim);
+	}
+
+	/**
+	Reallocates the buffer and sets all entries to zero.
+	*/
+	void resize(int numBlocks, int blockDim) {
+		numBlocks_ = numBlocks;
+		blockDim_ = blockDim;
+		data_ = Eigen::VectorXd::Zero(static_cast<Eigen::VectorXd::Index>(numBlocks) * blockDim);
+	}
+
+	int numBlocks() const {return numBlocks_;}
+	int blockDim() const {return blockDim_;}
+
+	Block operator[](int i) {return Block(data_.data() + offset(i), blockDim_);}
+	ConstBlock operator[](int i) const {return ConstBlock(data_.data() + offset(i), blockDim_);}
+
+	/**
+	Raw access to the buffer. Block i starts at data() + i * blockDim().
+	*/
+	double *data() {return data_.data();}
+	const double *data() const {return data_.data();}
+
+	/**
+	All blocks concatenated into one vector.
+	*/
+	const Eigen::VectorXd &vector() const {return data_;}
+
+private:
+	long long offset(int i) const {return static_cast<long long>(i) * blockDim_;}
+
+	Eigen::VectorXd data_;
+	int numBlocks_;
+	int blockDim_;
+};
+
+#endif
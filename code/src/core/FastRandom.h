@@ -0,0 +1,76 @@
+#ifndef _RCD_FASTRANDOM_H_
+#define _RCD_FASTRANDOM_H_
+
+#include <cstdint>
+
+/**
+ * xoshiro256++ pseudo-random generator (Blackman & Vigna). Much cheaper than
+ * std::default_random_engine and with far better statistical quality.
+ * Satisfies UniformRandomBitGenerator, so it also works with the <random>
+ * distributions, but bounded() and uniform() should be preferred on hot paths.
+ */
+class Xoshiro256 {
+public:
+	typedef uint64_t result_type;
+
+	explicit Xoshiro256(uint64_t seed = 0) {
+		//Expand the seed with splitmix64, which never yields an all-zero state
+		for(int k = 0; k < 4; ++k) {
+			seed += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			s_[k] = z ^ (z >> 31);
+		}
+	}
+
+	static constexpr result_type min() {return 0;}
+	static constexpr result_type max() {return ~static_cast<result_type>(0);}
+
+	result_type operator()() {
+		uint64_t result = rotl(s_[0] + s_[3], 23) + s_[0];
+		uint64_t t = s_[1] << 17;
+
+		s_[2] ^= s_[0];
+		s_[3] ^= s_[1];
+		s_[1] ^= s_[2];
+		s_[0] ^= s_[3];
+		s_[2] ^= t;
+		s_[3] = rotl(s_[3], 45);
+
+		return result;
+	}
+
+	/**
+	Unbiased integer in [0, range), range > 0. Uses Lemire's multiply-shift
+	reduction; the rejection step (and its division) is only reached with
+	probability range / 2^32.
+	*/
+	uint32_t bounded(uint32_t range) {
+		uint64_t m = static_cast<uint64_t>(next32()) * range;
+		uint32_t low = static_cast<uint32_t>(m);
+
+		if(low < range) {
+			uint32_t threshold = -range % range;
+			while(low < threshold) {
+				m = static_cast<uint64_t>(next32()) * range;
+				low = static_cast<uint32_t>(m);
+			}
+		}
+
+		return static_cast<uint32_t>(m >> 32);
+	}
+
+	/**
+	Uniform double in [0, 1) with 53 random bits.
+	*/
+	double uniform() {return ((*this)() >> 11) * (1.0 / 9007199254740992.0);}
+
+private:
+	static uint64_t rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+	uint32_t next32() {return static_cast<uint32_t>((*this)() >> 32);}
+
+	uint64_t s_[4];
+};
+
+#endif
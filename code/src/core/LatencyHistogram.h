@@ -0,0 +1,70 @@
+#ifndef _RCD_LATENCYHISTOGRAM_H_
+#define _RCD_LATENCYHISTOGRAM_H_
+
+#include <cstdint>
+
+/**
+ * Histogram of durations in nanoseconds with one bucket per power of two,
+ * so recording a value costs a count-leading-zeros and an increment.
+ * Bucket k > 0 counts values in [2^k, 2^(k+1)), bucket 0 counts 0 and 1.
+ * Percentiles are therefore exact only to within a factor of two; the
+ * maximum is tracked exactly.
+ */
+class LatencyHistogram {
+public:
+	static const int NUM_BUCKETS = 48;
+
+	LatencyHistogram() {reset();}
+
+	void reset() {
+		for(int k = 0; k < NUM_BUCKETS; ++k) {buckets_[k] = 0;}
+		count_ = 0;
+		max_ = 0;
+	}
+
+	void record(uint64_t ns) {
+		int k = 63 - __builtin_clzll(ns | 1);
+		if(k >= NUM_BUCKETS) {k = NUM_BUCKETS - 1;}
+		++buckets_[k];
+		++count_;
+		if(ns > max_) {max_ = ns;}
+	}
+
+	void add(const LatencyHistogram &other) {
+		for(int k = 0; k < NUM_BUCKETS; ++k) {buckets_[k] += other.buckets_[k];}
+		count_ += other.count_;
+		if(other.max_ > max_) {max_ = other.max_;}
+	}
+
+	uint64_t count() const {return count_;}
+	uint64_t max() const {return max_;}
+
+	/**
+	Returns an upper bound on the q-quantile (0 < q <= 1): the end of the
+	bucket holding it, capped by the maximum. Returns 0 if empty.
+	*/
+	uint64_t quantile(double q) const {
+		if(count_ == 0) {return 0;}
+
+		uint64_t rank = static_cast<uint64_t>(q * count_);
+		if(rank < 1) {rank = 1;}
+
+		uint64_t seen = 0;
+		for(int k = 0; k < NUM_BUCKETS; ++k) {
+			seen += buckets_[k];
+			if(seen >= rank) {
+				uint64_t end = (uint64_t(2) << k) - 1;
+				return (end < max_) ?end :max_;
+			}
+		}
+
+		return max_;
+	}
+
+private:
+	uint64_t buckets_[NUM_BUCKETS];
+	uint64_t count_;
+	uint64_t max_;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef _RCD_LOCKTABLE_H_
+#define _RCD_LOCKTABLE_H_
+
+#include <utility>
+#include "core/PaddedArray.h"
+#include "core/Platform.h"
+#include "core/SpinLock.h"
+
+/**
+ * Heap allocated table of locks protecting a set of variables.
+ * Each lock occupies its own cache line. The table either has one lock per
+ * variable or a fixed number of stripes onto which variables are hashed,
+ * which bounds memory use for large problems at the cost of occasional
+ * false contention between variables sharing a stripe.
+ *
+ * Lock must provide lock(), unlock() and tryLock(), where tryLock returns true
+ * if the lock was already held and lock() returns the number of times it found
+ * the lock held while waiting (see SpinLock, TtasLock, TicketLock and McsLock).
+ * A thread must release the locks it holds in the reverse order of acquisition.
+ *
+ * The table counts, per thread, how many acquisitions found the lock held.
+ * Thread ids are taken from Platform::getThreadId() and must be smaller than
+ * the number of threads at construction time. The locking methods also return
+ * the number of failed attempts made while waiting, so that callers can keep
+ * finer statistics of their own.
+ */
+template<class Lock = SpinLock>
+class LockTable {
+public:
+	/**
+	 * Creates a table for numVars variables. If numStripes is positive
+	 * (and smaller than numVars) variables are hashed onto numStripes locks,
+	 * otherwise every variable gets its own lock.
+	 */
+	LockTable(int numVars, int numStripes = 0)
+		: numVars_(numVars),
+		  numLocks_((numStripes > 0 && numStripes < numVars) ?numStripes :numVars),
+		  locks_(numLocks_),
+		  contentions_(Platform::getNumLocalThreads()) {}
+
+	int numVars() const {return numVars_;}
+	int numLocks() const {return numLocks_;}
+	bool isStriped() const {return numLocks_ < numVars_;}
+
+	/**
+	Returns the index of the lock protecting the given variable.
+	*/
+	int stripe(int varId) const {
+		if(!isStriped()) {return varId;}
+
+		//Multiplicative hashing spreads neighbouring ids over different stripes
+		unsigned int h = static_cast<unsigned int>(varId) * 2654435761u;
+		return static_cast<int>(h % static_cast<unsigned int>(numLocks_));
+	}
+
+	int lock(int varId) {return acquire(stripe(varId));}
+	void unlock(int varId) {locks_[stripe(varId)].unlock();}
+
+	/**
+	 * Locks two variables. Locks are acquired in increasing stripe order to avoid
+	 * deadlocks; if both variables share a stripe it is acquired once.
+	 */
+	int lockPair(int i, int j) {
+		int s1 = stripe(i);
+		int s2 = stripe(j);
+
+		if(s1 == s2) {return acquire(s1);}
+		if(s1 > s2) {std::swap(s1, s2);}
+		int spins = acquire(s1);
+		return spins + acquire(s2);
+	}
+
+	void unlockPair(int i, int j) {
+		int s1 = stripe(i);
+		int s2 = stripe(j);
+
+		if(s1 == s2) {locks_[s1].unlock(); return;}
+		if(s1 > s2) {std::swap(s1, s2);}
+		locks_[s2].unlock();
+		locks_[s1].unlock();
+	}
+
+	/**
+	Number of acquisitions that found the lock held, summed over threads.
+	*/
+	long long getNumContentions() const {
+		long long sum = 0;
+		for(size_t t = 0; t < contentions_.size(); ++t) {sum += contentions_[t];}
+		return sum;
+	}
+
+	size_t memoryBytes() const {return locks_.memoryBytes();}
+
+private:
+	int acquire(int s) {
+		int spins = locks_[s].lock();
+		if(spins > 0) {++contentions_[Platform::getThreadId()];}
+		return spins;
+	}
+
+	int numVars_;
+	int numLocks_;
+	PaddedArray<Lock> locks_;
+	PaddedArray<long long> contentions_;
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/MappedFile.h"
+
+MappedFile::MappedFile(const char *fileName)
+	: data_(0), size_(0) {
+	int fd = open(fileName, O_RDONLY);
+	if(fd < 0) {throw FileFormatException(std::string("Cannot open ") + fileName);}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0) {
+		close(fd);
+		throw FileFormatException(std::string("Cannot stat ") + fileName);
+	}
+
+	size_ = st.st_size;
+
+	if(size_ > 0) {
+		void *p = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p == MAP_FAILED) {
+			close(fd);
+			throw FileFormatException(std::string("Cannot map ") + fileName);
+		}
+
+		data_ = static_cast<const char *>(p);
+	}
+
+	//The mapping stays valid after the descriptor is closed
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if(data_) {munmap(const_cast<char *>(data_), size_);}
+}
@@ -0,0 +1,38 @@
+#ifndef _RCD_MAPPEDFILE_H_
+#define _RCD_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Thrown when a file cannot be opened, mapped or has invalid contents.
+ */
+class FileFormatException : public std::runtime_error {
+ public:
+	FileFormatException(const std::string &msg)
+		: std::runtime_error(msg) {}
+};
+
+/**
+ * Read-only memory mapping of an entire file. Pages are loaded on demand
+ * by the operating system, so mapping a file does not read it.
+ * The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+ public:
+	MappedFile(const char *fileName);
+	~MappedFile();
+
+	const char *data() const {return data_;}
+	size_t size() const {return size_;}
+
+ private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+	const char *data_;
+	size_t size_;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef _RCD_MCSLOCK_H_
+#define _RCD_MCSLOCK_H_
+
+#include <atomic>
+#include "core/Platform.h"
+
+/**
+ * Mellor-Crummey & Scott queue lock. Waiting threads form a linked list and
+ * each one spins on a flag in its own queue node, so an unlock invalidates a
+ * single cache line (the successor's) instead of every waiter's copy of the
+ * lock. The lock is granted in FIFO order.
+ *
+ * Queue nodes come from a small per-thread stack, which keeps the usual
+ * lock()/unlock() interface. A thread may therefore hold at most
+ * MAX_HELD MCS locks at a time, and must release them on the thread that
+ * acquired them, in the reverse order of acquisition (as LockTable does).
+ * Occupies a full cache line.
+ */
+class alignas(Platform::CACHE_LINE_SIZE) McsLock {
+public:
+	static const int MAX_HELD = 8;
+
+	McsLock()
+		: tail_(0), holder_(0) {}
+
+	bool tryLock() {
+		Node *node = pushNode();
+		Node *expected = 0;
+
+		if(tail_.compare_exchange_strong(expected, node,
+				std::memory_order_acquire, std::memory_order_relaxed)) {
+			holder_ = node;
+			return false;
+		}
+
+		popNode(node);
+		return true;
+	}
+
+	int lock() {
+		Node *node = pushNode();
+		node->locked.store(true, std::memory_order_relaxed);
+
+		int spins = 0;
+		Node *pred = tail_.exchange(node, std::memory_order_acq_rel);
+		if(pred) {
+			pred->next.store(node, std::memory_order_release);
+			while(node->locked.load(std::memory_order_acquire)) {
+				Platform::spinWait(spins++);
+			}
+		}
+
+		holder_ = node;
+		return spins;
+	}
+
+	void unlock() {
+		Node *node = holder_;
+		Node *next = node->next.load(std::memory_order_acquire);
+
+		if(!next) {
+			Node *expected = node;
+			if(tail_.compare_exchange_strong(expected, 0,
+					std::memory_order_release, std::memory_order_relaxed)) {
+				popNode(node);
+				return;
+			}
+
+			//A successor swapped itself in but has not linked to us yet
+			for(int k = 0; !(next = node->next.load(std::memory_order_acquire)); ++k) {Platform::spinWait(k);}
+		}
+
+		next->locked.store(false, std::memory_order_release);
+		popNode(node);
+	}
+
+private:
+	struct alignas(Platform::CACHE_LINE_SIZE) Node {
+		std::atomic<Node *> next;
+		std::atomic<bool> locked;
+	};
+
+	struct NodeStack {
+		NodeStack() : depth(0) {}
+
+		Node nodes[MAX_HELD];
+		int depth;
+	};
+
+	static NodeStack &threadNodes() {
+		static thread_local NodeStack stack;
+		return stack;
+	}
+
+	static Node *pushNode() {
+		NodeStack &stack = threadNodes();
+		assert(stack.depth < MAX_HELD);
+		Node *node = &stack.nodes[stack.depth++];
+		node->next.store(0, std::memory_order_relaxed);
+		return node;
+	}
+
+	static void popNode(Node *node) {
+		NodeStack &stack = threadNodes();
+		assert(stack.depth > 0 && node == &stack.nodes[stack.depth - 1]);
+		--stack.depth;
+	}
+
+	std::atomic<Node *> tail_;
+	Node *holder_; //Only accessed by the thread holding the lock
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _RCD_PADDEDARRAY_H_
+#define _RCD_PADDEDARRAY_H_
+
+#include <new>
+#include "core/Platform.h"
+
+/**
+ * Fixed-size heap array in which every element starts on its own cache line,
+ * so that elements written by different threads never share a cache line.
+ * T must be default constructible. Elements are value-initialized, so
+ * arithmetic types start at zero.
+ */
+template<class T>
+class PaddedArray {
+	struct alignas(Platform::CACHE_LINE_SIZE) Slot {
+		T value;
+	};
+
+public:
+	explicit PaddedArray(size_t size = 0)
+		: slots_(0), size_(0) {
+		resize(size);
+	}
+
+	~PaddedArray() {release();}
+
+	/**
+	Discards the current contents and allocates "size" value-initialized elements.
+	*/
+	void resize(size_t size) {
+		release();
+		slots_ = static_cast<Slot *>(Platform::alignedMalloc(size * sizeof(Slot)));
+		size_ = size;
+		for(size_t i = 0; i < size_; ++i) {new (slots_ + i) Slot();}
+	}
+
+	T &operator[](size_t i) {return slots_[i].value;}
+	const T &operator[](size_t i) const {return slots_[i].value;}
+
+	size_t size() const {return size_;}
+	size_t memoryBytes() const {return size_ * sizeof(Slot);}
+
+private:
+	PaddedArray(const PaddedArray &);
+	PaddedArray &operator=(const PaddedArray &);
+
+	void release() {
+		if(!slots_) {return;}
+		for(size_t i = 0; i < size_; ++i) {slots_[i].~Slot();}
+		Platform::alignedFree(slots_);
+		slots_ = 0;
+		size_ = 0;
+	}
+
+	Slot *slots_;
+	size_t size_;
+};
+
+#endif
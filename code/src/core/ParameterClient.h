@@ -35,6 +35,19 @@ class ParameterUpdateClient {
 			const Eigen::VectorXd& increment1,
 			const Eigen::VectorXd& increment2, bool async) = 0;
 
+	/**
+	Same as update, but the caller guarantees that no other thread updates
+	varId1 or varId2 meanwhile (e.g. it holds their versions), so clients
+	may skip their own per-variable locking. async has the same meaning as in
+	update: state shared with other variables (e.g. the SVM gradient) must be
+	updated atomically.
+	*/
+	virtual void updateExclusive(int varId1, int varId2,
+			const Eigen::VectorXd& increment1,
+			const Eigen::VectorXd& increment2, bool async) {
+		update(varId1, varId2, increment1, increment2, async);
+	}
+
 	virtual void init(int varId) = 0;
 };
 
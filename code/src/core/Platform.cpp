@@ -3,6 +3,7 @@
 #include <sys/types.h>
 #include <signal.h>
 #include <unistd.h>
+#include <sched.h>
 #include <stacktrace.h>
 #include <Eigen/Core>
 #include "core/Platform.h"
@@ -98,7 +99,54 @@ void Platform::waitForDebugger() {
 }
 
 
-void Platform::updateVector(Eigen::VectorXd &v, const Eigen::VectorXd &increment,
+void *Platform::alignedMalloc(size_t bytes) {
+	void *p = 0;
+	if(posix_memalign(&p, CACHE_LINE_SIZE, bytes > 0 ? bytes : CACHE_LINE_SIZE) != 0) {
+		throw std::bad_alloc();
+	}
+
+	return p;
+}
+
+void Platform::alignedFree(void *p) {
+	free(p);
+}
+
+#ifdef __linux__
+//Affinity of a pinned thread before its first pinCurrentThread
+static thread_local bool hasSavedAffinity = false;
+static thread_local cpu_set_t savedAffinity;
+#endif
+
+bool Platform::pinCurrentThread(int cpu) {
+#ifdef __linux__
+	long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(numCpus <= 0) {return false;}
+
+	if(!hasSavedAffinity) {
+		if(sched_getaffinity(0, sizeof(savedAffinity), &savedAffinity) != 0) {return false;}
+		hasSavedAffinity = true;
+	}
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu % numCpus, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+void Platform::unpinCurrentThread() {
+#ifdef __linux__
+	if(!hasSavedAffinity) {return;}
+
+	sched_setaffinity(0, sizeof(savedAffinity), &savedAffinity);
+	hasSavedAffinity = false;
+#endif
+}
+
+void Platform::updateVector(Eigen::Ref<Eigen::VectorXd> v, const Eigen::VectorXd &increment,
 		bool atomicComponentUpdates) {
 	if(atomicComponentUpdates) {
 		double *raw = v.data();
@@ -118,7 +166,7 @@ void Platform::updateVector(Eigen::VectorXd &v, const Eigen::VectorXd &increment
 	}
 }
 
-void Platform::updateVector(Eigen::VectorXd &v,
+void Platform::updateVector(Eigen::Ref<Eigen::VectorXd> v,
 			const Eigen::SparseVector<double> &increment, bool atomicComponentUpdates) {
 	if(atomicComponentUpdates) {
 		double *raw = v.data();
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <iostream>
 #include <atomic>
+#include <thread>
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 
@@ -16,6 +17,9 @@ class Platform {
 public:
 	typedef std::chrono::time_point<std::chrono::system_clock> Time;
 
+	//Assumed size of a cache line, used to pad data written by different threads
+	static const int CACHE_LINE_SIZE = 64;
+
 	static int processId;
 	static int numProcesses;
 
@@ -49,11 +53,56 @@ public:
 
 	static void waitForDebugger();
 
+	/**
+	Allocates memory aligned to a cache line. Must be released with alignedFree.
+	*/
+	static void *alignedMalloc(size_t bytes);
+	static void alignedFree(void *p);
+
+	/**
+	Binds the calling thread to a CPU (modulo the number of online CPUs).
+	The first call on a thread saves its previous affinity for
+	unpinCurrentThread. Returns false if pinning is not supported or failed.
+	*/
+	static bool pinCurrentThread(int cpu);
+
+	/**
+	Restores the affinity the calling thread had before it was first pinned.
+	Does nothing if the thread is not pinned.
+	*/
+	static void unpinCurrentThread();
+
 	static void printInfo(std::ostream &out = std::cerr) {
 		out << "Process " << processId << " of " << numProcesses << std::endl;
 		out << "Number of local threads: " << getNumLocalThreads() << std::endl;	
 	}
 
+	/**
+	Hints the CPU that the caller is busy-waiting (PAUSE on x86, YIELD on ARM),
+	which frees pipeline resources for a sibling hyperthread and avoids the
+	memory-order flush when the wait ends.
+	*/
+	static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		asm volatile("yield" ::: "memory");
+#endif
+	}
+
+	/**
+	One step of a busy-wait loop, where spins is the number of steps taken so
+	far. Pauses at first, then yields the CPU, so that the thread the waiter
+	depends on (a preempted lock holder, or the next in line of a FIFO lock)
+	can run when there are more threads than cores.
+	*/
+	static void spinWait(int spins) {
+		if(spins < SPINS_BEFORE_YIELD) {cpuRelax();}
+		else {std::this_thread::yield();}
+	}
+
+	static const int SPINS_BEFORE_YIELD = 1024;
+
 	static Time getCurrentTime() {
 		return std::chrono::system_clock::now();
 	}
@@ -92,11 +141,28 @@ public:
 		}while(!succeed);
 	}
 
-	static void updateVector(Eigen::VectorXd &v,
+	static void updateVector(Eigen::Ref<Eigen::VectorXd> v,
 			const Eigen::VectorXd &increment, bool atomicComponentUpdates);
 
+	/**
+	Adds scale * x to the dense array v, where x is a sparse vector given by
+	its nonzero indices and values. Does not allocate temporaries.
+	*/
+	static void addScaledSparse(double *v, const int *indices, const double *values,
+			int nnz, double scale, bool atomicComponentUpdates) {
+		if(atomicComponentUpdates) {
+			for(int k = 0; k < nnz; ++k) {
+				atomicAdd(v + indices[k], scale * values[k]);
+			}
+		} else {
+			for(int k = 0; k < nnz; ++k) {
+				v[indices[k]] += scale * values[k];
+			}
+		}
+	}
+
 
-	static void updateVector(Eigen::VectorXd &v,
+	static void updateVector(Eigen::Ref<Eigen::VectorXd> v,
 			const Eigen::SparseVector<double> &increment, bool atomicComponentUpdates);
 
 	static void copyVector(const Eigen::VectorXd &src, Eigen::VectorXd &dst,
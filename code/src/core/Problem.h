@@ -2,7 +2,10 @@
 #define _RCD_PROBLEM_H_
 
 #include <functional>
+#include <memory>
 #include <Eigen/Dense>
+#include "core/ActiveSet.h"
+#include "core/BlockVector.h"
 #include "core/ParameterClient.h"
 
 typedef std::function<double (const Eigen::VectorXd &)> SingleVarFunction;
@@ -68,8 +71,7 @@ class Problem {
 	friend class LocalParameterUpdateClient<NodeInfoSpec>;
 public:
 	Problem(int numVars, int varDim) :
-			numVars_(numVars), varDim_(varDim) {
-		x_.resize(numVars);
+			x_(numVars, varDim), numVars_(numVars), varDim_(varDim), shrinking_(false) {
 	}
 
 	~Problem() {}
@@ -85,10 +87,84 @@ public:
 	virtual RCDNode<NodeInfoSpec> *createNode(int varId) = 0;
 	virtual double computeObjective() const = 0;
 
+	/**
+	 * Called by every worker thread of a local scheduler at a point where no
+	 * updates are in progress (e.g. between convergence blocks), allowing the
+	 * problem to recompute derived state that is maintained incrementally.
+	 * "block" is the number of blocks completed so far. Implementations should
+	 * split the work among the numThreads callers. Other threads may still be
+	 * refreshing, so state refreshed by another thread must not be read here.
+	 */
+	virtual void refreshState(int block, int threadId, int numThreads) {}
+
+	/**
+	 * Called by one thread of a local scheduler before each convergence block
+	 * (including the first), after all threads have finished refreshState,
+	 * while no updates are in progress. With shrinking enabled, drops stuck
+	 * variables from the active set; overrides must call this first.
+	 */
+	virtual void beginBlock() {
+		if(shrinking_) {shrink();}
+	}
+
+	/**
+	 * Measure of optimality that local schedulers compare against their
+	 * tolerance instead of the change of the objective between blocks (e.g.
+	 * the maximal KKT violation of an SVM dual). Negative if there is none.
+	 */
+	virtual double optimalityGap() const {return -1.0;}
+
+	/**
+	 * Enables shrinking for problems whose update clients report stuck variables
+	 * (see ActiveSet). Variables that stay at a bound for "patience" consecutive
+	 * updates are dropped from activeSet() at the start of each block.
+	 * Only selectors that draw from activeSet() (e.g. ActiveSetPairs) benefit.
+	 */
+	void enableShrinking(int patience) {
+		activeSet_.reset(new ActiveSet(numVars_, patience));
+		shrinking_ = true;
+	}
+
+	/**
+	Returns null unless shrinking was enabled.
+	*/
+	const ActiveSet *activeSet() const {return activeSet_.get();}
+
+	int numActiveVars() const {return activeSet_ ?activeSet_->size() :numVars_;}
+
+	/**
+	 * Called by schedulers before declaring convergence, at a point where no
+	 * updates are in progress. Makes all variables active again and stops
+	 * shrinking, so that the solver finishes on the full problem. Returns true
+	 * if any variable was inactive, in which case the solver should continue.
+	 */
+	virtual bool restoreInactive() {
+		if(!shrinking_) {return false;}
+		shrinking_ = false;
+		return activeSet_->restoreAll();
+	}
+
 protected:
-	std::vector<Eigen::VectorXd> x_;
+	/**
+	 * Drops stuck variables from the active set. Problems that know their
+	 * gradient override this to only drop variables that cannot currently
+	 * improve the objective.
+	 */
+	virtual void shrink() {activeSet_->compact();}
+
+	/**
+	Reports whether an update left a variable at a bound without changing it.
+	*/
+	void recordActivity(int varId, bool stuck) {
+		if(shrinking_) {activeSet_->record(varId, stuck);}
+	}
+
+	BlockVector x_;
 	int numVars_;
 	int varDim_;
+
+	std::shared_ptr<ActiveSet> activeSet_;
+	bool shrinking_;
 };
 
 template<class InfoSpec>
@@ -105,7 +181,7 @@ void LocalParameterUpdateClient<InfoSpec>::update(int varId1, int varId2, const
 
 template<class InfoSpec>
 void LocalParameterUpdateClient<InfoSpec>::init(int varId) {
-	problem_->x_[varId] = Eigen::VectorXd(problem_->varDim_);
+	problem_->x_[varId].setZero();
 }
 
 template<class NodeInfoSpec>
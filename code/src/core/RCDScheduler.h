@@ -2,6 +2,7 @@
 
 #define _RCD_RCDSCHEDULER_H
 
+#include <cmath>
 #include <functional>
 #include <limits>
 #include <unordered_map>
@@ -9,6 +10,7 @@
 #include "core/RCDNode.h"
 #include "core/Platform.h"
 #include "core/Problem.h"
+#include "core/TraceRecorder.h"
 
 typedef std::function<void (int iteration, int time, double objective)> IterationListener;
 
@@ -65,6 +67,7 @@ class RCDScheduler {
  RCDScheduler()
 	 : maxIterations_(100000), eps_(1e-5)
 		, minObj_(-std::numeric_limits<double>::infinity())
+		, trace_(0)
 		{}
 
 	virtual ~RCDScheduler() {}
@@ -74,6 +77,12 @@ class RCDScheduler {
 	void setMinObjective(double minObj) {minObj_ = minObj;}
 
 	void setListenerIteration(IterationListener listener) {iterationListener_ = listener;}
+
+	/**
+	Records initialization phases, blocks, barrier waits, objective
+	evaluations and pair updates in the given recorder (null disables tracing).
+	*/
+	void setTraceRecorder(TraceRecorder *recorder) {trace_ = recorder;}
 	void setParameterReadClient(ParameterReadClient<NodeInput, NodeStaticInput> *readClient) {
 		this->readClient_ = readClient;
 	}
@@ -109,15 +118,32 @@ class RCDScheduler {
 
 	ParameterReadClient<NodeInput, NodeStaticInput> *readClient_;
 	ParameterUpdateClient *updateClient_;
+	TraceRecorder *trace_;
 };
 
 template <class InfoSpec>
 class RCDLocalScheduler : public RCDScheduler<InfoSpec> {
 	typedef RCDScheduler<InfoSpec> Super;
 public:
+	RCDLocalScheduler()
+		: problem_(0) {}
+
 	virtual void readProblem(Problem<InfoSpec> *problem);
 
 protected:
+	/**
+	 * Convergence test at the end of a block: compares the problem's optimality
+	 * gap with the tolerance if the problem has one, otherwise the change of
+	 * the objective since the previous block.
+	 */
+	bool withinTolerance(double prevObj, double obj) const {
+		if(this->eps_ <= 0.0) {return false;}
+
+		double gap = problem_ ?problem_->optimalityGap() :-1.0;
+		if(gap >= 0.0) {return gap < this->eps_;}
+		return fabs(prevObj - obj) < this->eps_;
+	}
+
 	Problem<InfoSpec> *problem_;
 };
 
@@ -129,6 +155,7 @@ OptOutput RCDScheduler<InfoSpec>::solve() {
 	int numInitPhases = nodes_[0]->getNumInitPhases();
 
 	for(int phase = 0; phase < numInitPhases; ++phase) {
+		TraceScope traceInit(trace_, "init_phase", phase);
 #pragma omp parallel for schedule(dynamic)
 		for(int i = 0; i < numVars; ++i) {
 			updateClient_->init(i);
@@ -0,0 +1,73 @@
+#ifndef _RCD_SEQLOCK_H_
+#define _RCD_SEQLOCK_H_
+
+#include <atomic>
+#include <memory>
+
+#include "core/Platform.h"
+
+/**
+ * Sequence counters guarding an array of doubles that is written under
+ * external mutual exclusion (e.g. per-variable locks) and read without locks.
+ * A counter is odd while its entry is being written. Readers retry until they
+ * observe the same even counters before and after reading, so they never
+ * block writers and always obtain a consistent snapshot.
+ */
+class SeqLockArray {
+public:
+	SeqLockArray(int size)
+		: size_(size), seq_(new std::atomic<unsigned>[size]) {
+		for(int k = 0; k < size; ++k) {seq_[k].store(0, std::memory_order_relaxed);}
+	}
+
+	int size() const {return size_;}
+
+	/**
+	Must be called by the (only) writer of entry k before modifying it.
+	*/
+	void beginWrite(int k) {
+		seq_[k].store(seq_[k].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void endWrite(int k) {
+		seq_[k].store(seq_[k].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/**
+	Reads values[i] and values[j] as they were at a single point in time.
+	*/
+	void readPair(const double *values, int i, int j, double &vi, double &vj) const {
+		const volatile double *v = values;
+
+		for(int spins = 0; ; ++spins) {
+			unsigned si = seq_[i].load(std::memory_order_acquire);
+			unsigned sj = seq_[j].load(std::memory_order_acquire);
+
+			//A writer is in the middle of an update, let it finish
+			if((si | sj) & 1) {
+				Platform::spinWait(spins);
+				continue;
+			}
+
+			vi = v[i];
+			vj = v[j];
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if(seq_[i].load(std::memory_order_relaxed) == si
+			   && seq_[j].load(std::memory_order_relaxed) == sj) {
+				return;
+			}
+
+			Platform::spinWait(spins);
+		}
+	}
+
+	unsigned version(int k) const {return seq_[k].load(std::memory_order_acquire);}
+
+private:
+	int size_;
+	std::unique_ptr<std::atomic<unsigned>[]> seq_;
+};
+
+#endif
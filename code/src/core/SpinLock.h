@@ -12,11 +12,15 @@ public:
 		return locked.test_and_set(std::memory_order_acquire);
 	}
 
-	void lock() {
-		while(tryLock());
+	/**
+	Returns the number of failed attempts made while waiting.
+	*/
+	int lock() {
+		int spins = 0;
+		while(tryLock()) {++spins;}
+		return spins;
 	}
 
-	
 	void unlock() {locked.clear(std::memory_order_release);}
 
 private:
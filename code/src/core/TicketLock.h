@@ -0,0 +1,64 @@
+#ifndef _RCD_TICKETLOCK_H_
+#define _RCD_TICKETLOCK_H_
+
+#include <atomic>
+#include <thread>
+#include "core/Platform.h"
+
+/**
+ * FIFO ticket lock. Each thread takes a ticket with a single fetch_add and
+ * waits until the lock serves it, so the lock is granted in arrival order
+ * and no thread starves. Waiters pause in proportion to their distance from
+ * the head of the queue, which keeps the polling of the shared counter low,
+ * and yield the CPU once they have waited for long.
+ * Occupies a full cache line.
+ */
+class alignas(Platform::CACHE_LINE_SIZE) TicketLock {
+public:
+	TicketLock()
+		: next_(0), serving_(0) {}
+
+	/**
+	Succeeds only if nobody holds or waits for the lock.
+	*/
+	bool tryLock() {
+		unsigned s = serving_.load(std::memory_order_acquire);
+		return !next_.compare_exchange_strong(s, s + 1,
+				std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	int lock() {
+		unsigned ticket = next_.fetch_add(1, std::memory_order_relaxed);
+		int spins = 0;
+		int waited = 0;
+
+		while(true) {
+			unsigned s = serving_.load(std::memory_order_acquire);
+			if(s == ticket) {return spins;}
+			++spins;
+
+			//Once the waiter has paused for long it yields once per poll
+			//instead of pausing
+			unsigned pauses = (ticket - s) * PAUSES_PER_WAITER;
+			if(waited < Platform::SPINS_BEFORE_YIELD) {
+				for(unsigned k = 0; k < pauses; ++k) {Platform::cpuRelax();}
+				waited += pauses;
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void unlock() {
+		//Only the holder writes serving_
+		serving_.store(serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	static const unsigned PAUSES_PER_WAITER = 16;
+
+	std::atomic<unsigned> next_;
+	std::atomic<unsigned> serving_;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <fstream>
+#include <string>
+#include "core/MappedFile.h"
+#include "core/TraceRecorder.h"
+
+using namespace std;
+
+TraceRecorder::TraceRecorder(int numThreads, int eventsPerThread)
+	: eventsPerThread_(eventsPerThread), detailCapacity_(eventsPerThread - eventsPerThread / 16)
+	, start_(Clock::now()), buffers_(numThreads) {
+	for(int t = 0; t < numThreads; ++t) {
+		buffers_[t].events.reset(new Event[eventsPerThread]);
+	}
+}
+
+long long TraceRecorder::numEvents() const {
+	long long n = 0;
+	for(size_t t = 0; t < buffers_.size(); ++t) {n += buffers_[t].size;}
+	return n;
+}
+
+long long TraceRecorder::numDropped() const {
+	long long n = 0;
+	for(size_t t = 0; t < buffers_.size(); ++t) {n += buffers_[t].dropped;}
+	return n;
+}
+
+void TraceRecorder::write(ostream &out) const {
+	int pid = Platform::processId;
+	out << "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":" << numDropped()
+		<< "},\n\"traceEvents\":[\n";
+	out << fixed;
+	out.precision(3);
+
+	bool first = true;
+	for(size_t t = 0; t < buffers_.size(); ++t) {
+		const Buffer &b = buffers_[t];
+		if(b.size == 0 && b.dropped == 0) {continue;}
+
+		if(!first) {out << ",\n";}
+		first = false;
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << t
+			<< ",\"args\":{\"name\":\"thread " << t << "\"}}";
+
+		//Complete events, timestamps in microseconds
+		for(int k = 0; k < b.size; ++k) {
+			const Event &e = b.events[k];
+			out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":" << pid
+				<< ",\"tid\":" << t << ",\"ts\":" << e.begin * 1e-3
+				<< ",\"dur\":" << (e.end - e.begin) * 1e-3;
+
+			if(e.arg0 >= 0) {
+				out << ",\"args\":{\"i\":" << e.arg0;
+				if(e.arg1 >= 0) {out << ",\"j\":" << e.arg1;}
+				out << "}";
+			}
+
+			out << "}";
+		}
+	}
+
+	out << "\n]}\n";
+}
+
+void TraceRecorder::write(const char *fileName) const {
+	ofstream out(fileName);
+	if(!out) {throw FileFormatException(string("Cannot create ") + fileName);}
+	write(out);
+	if(!out) {throw FileFormatException(string("Failed writing ") + fileName);}
+}
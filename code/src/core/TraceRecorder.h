@@ -0,0 +1,122 @@
+#ifndef _RCD_TRACERECORDER_H_
+#define _RCD_TRACERECORDER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include "core/PaddedArray.h"
+#include "core/Platform.h"
+
+/**
+ * Records timed events of the worker threads for display on a timeline
+ * (chrome://tracing or ui.perfetto.dev).
+ *
+ * Every thread appends to its own preallocated buffer, so recording takes
+ * no locks and does not allocate. Once a thread's buffer is full further
+ * events of that thread are counted and dropped. Events of threads with an
+ * id beyond the number given at construction are dropped as well.
+ *
+ * Detail events (e.g. single pair updates) may only fill 15/16 of a buffer,
+ * so that blocks, barriers and objective evaluations remain visible until
+ * the end of long runs.
+ *
+ * Event names must be string literals (or otherwise outlive the recorder).
+ */
+class TraceRecorder {
+public:
+	struct Event {
+		const char *name;
+		int64_t begin; //ns since construction
+		int64_t end;
+		int arg0; //Optional arguments (e.g. the pair of variables), -1 if unused
+		int arg1;
+	};
+
+	TraceRecorder(int numThreads, int eventsPerThread = 1 << 18);
+
+	int64_t now() const {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				Clock::now() - start_).count();
+	}
+
+	/**
+	Adds an event of the calling thread that started at the given time
+	(as returned by now()) and ends now.
+	*/
+	void record(const char *name, int64_t begin, int arg0 = -1, int arg1 = -1,
+			bool detail = false) {
+		int64_t end = now();
+		int tid = Platform::getThreadId();
+		if(tid >= static_cast<int>(buffers_.size())) {return;}
+
+		Buffer &b = buffers_[tid];
+		if(b.size >= (detail ?detailCapacity_ :eventsPerThread_)) {++b.dropped; return;}
+
+		Event &e = b.events[b.size++];
+		e.name = name;
+		e.begin = begin;
+		e.end = end;
+		e.arg0 = arg0;
+		e.arg1 = arg1;
+	}
+
+	long long numEvents() const;
+	long long numDropped() const;
+
+	/**
+	Writes all events in Chrome trace-event JSON format. Must not be called
+	while threads are recording.
+	*/
+	void write(std::ostream &out) const;
+
+	/**
+	Writes to a file, throws FileFormatException if it cannot be written.
+	*/
+	void write(const char *fileName) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Buffer {
+		Buffer() : size(0), dropped(0) {}
+
+		std::unique_ptr<Event[]> events;
+		int size;
+		long long dropped;
+	};
+
+	TraceRecorder(const TraceRecorder &);
+	TraceRecorder &operator=(const TraceRecorder &);
+
+	int eventsPerThread_;
+	int detailCapacity_;
+	Clock::time_point start_;
+	PaddedArray<Buffer> buffers_;
+};
+
+/**
+ * Records an event spanning the lifetime of the object in the calling
+ * thread's buffer. Does nothing if the recorder is null.
+ */
+class TraceScope {
+public:
+	TraceScope(TraceRecorder *recorder, const char *name, int arg0 = -1, int arg1 = -1,
+			bool detail = false)
+		: recorder_(recorder), name_(name), arg0_(arg0), arg1_(arg1), detail_(detail)
+		, begin_(recorder ?recorder->now() :0) {}
+
+	~TraceScope() {
+		if(recorder_) {recorder_->record(name_, begin_, arg0_, arg1_, detail_);}
+	}
+
+private:
+	TraceRecorder *recorder_;
+	const char *name_;
+	int arg0_;
+	int arg1_;
+	bool detail_;
+	int64_t begin_;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _RCD_TTASLOCK_H_
+#define _RCD_TTASLOCK_H_
+
+#include <atomic>
+#include "core/Platform.h"
+
+/**
+ * Test-and-test-and-set lock with exponential backoff. Waiting threads spin
+ * on a plain load, which hits their own cached copy of the line, and only
+ * attempt the exchange once the lock looks free. After a failed exchange
+ * the thread backs off for a randomized, doubling number of pauses, so that
+ * the threads released by an unlock do not all retry at once.
+ * Occupies a full cache line.
+ */
+class alignas(Platform::CACHE_LINE_SIZE) TtasLock {
+public:
+	TtasLock()
+		: locked_(false) {}
+
+	bool tryLock() {
+		return locked_.load(std::memory_order_relaxed)
+			|| locked_.exchange(true, std::memory_order_acquire);
+	}
+
+	int lock() {
+		int spins = 0;
+		unsigned backoff = MIN_BACKOFF;
+		unsigned seed = static_cast<unsigned>(reinterpret_cast<size_t>(&spins));
+
+		while(true) {
+			while(locked_.load(std::memory_order_relaxed)) {
+				Platform::spinWait(spins++);
+			}
+
+			if(!locked_.exchange(true, std::memory_order_acquire)) {return spins;}
+			++spins;
+
+			//Wait for a random number of pauses in [backoff/2, backoff)
+			seed = seed * 1103515245u + 12345u;
+			unsigned pauses = backoff / 2 + (seed >> 16) % (backoff / 2);
+			for(unsigned k = 0; k < pauses; ++k) {Platform::cpuRelax();}
+			if(backoff < MAX_BACKOFF) {backoff *= 2;}
+		}
+	}
+
+	void unlock() {locked_.store(false, std::memory_order_release);}
+
+private:
+	static const unsigned MIN_BACKOFF = 4;
+	static const unsigned MAX_BACKOFF = 1024;
+
+	std::atomic<bool> locked_;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include <cassert>
+#include "environments/AliasTable.h"
+
+using namespace std;
+
+int AliasTable::add(const double *weights, int n) {
+	assert(n > 0);
+	int begin = offset_.back();
+
+	double total = 0.0;
+	for(int k = 0; k < n; ++k) {
+		assert(weights[k] >= 0);
+		total += weights[k];
+	}
+
+	prob_.resize(begin + n);
+	alias_.resize(begin + n);
+	double *prob = &prob_[begin];
+	int *alias = &alias_[begin];
+
+	//Scaled probabilities, with mean 1
+	vector<int> small, large;
+	int heaviest = 0;
+	for(int k = 0; k < n; ++k) {
+		prob[k] = (total > 0) ? weights[k] * n / total : 1.0;
+		alias[k] = k;
+		if(prob[k] < 1.0) {small.push_back(k);}
+		else {large.push_back(k);}
+		if(weights[k] > weights[heaviest]) {heaviest = k;}
+	}
+
+	while(!small.empty() && !large.empty()) {
+		int s = small.back(); small.pop_back();
+		int l = large.back();
+
+		alias[s] = l;
+		prob[l] -= 1.0 - prob[s];
+
+		if(prob[l] < 1.0) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+
+	//Leftovers are 1 up to rounding. A small entry that is further off (which
+	//rounding can only cause for tiny or zero weights) keeps its probability
+	//and gives the rest of its slot to the heaviest entry, so that zero
+	//weights are never drawn.
+	double tolerance = 1e-9 * n;
+	for(int k : small) {
+		if(prob[k] >= 1.0 - tolerance) {prob[k] = 1.0;}
+		else {alias[k] = heaviest;}
+	}
+
+	for(int k : large) {prob[k] = 1.0;}
+
+	offset_.push_back(begin + n);
+	return offset_.size() - 2;
+}
+
+double AliasTable::probability(int k, int d) const {
+	int begin = offset_[d];
+	int n = offset_[d+1] - begin;
+	double p = prob_[begin + k];
+
+	for(int m = 0; m < n; ++m) {
+		if(m != k && alias_[begin + m] == k) {p += 1.0 - prob_[begin + m];}
+	}
+
+	return p / n;
+}
@@ -0,0 +1,70 @@
+#ifndef _RCD_ALIASTABLE_H_
+#define _RCD_ALIASTABLE_H_
+
+#include <vector>
+#include <random>
+
+/**
+ * Walker/Vose alias tables for sampling from discrete distributions in O(1).
+ * Several distributions can be stored back to back (CSR layout), e.g. one per
+ * node over its neighbours; distribution d occupies entries
+ * [offset(d), offset(d+1)) of the probability and alias arrays.
+ *
+ * Tables are immutable once built, so one table can be shared by all threads
+ * as long as each thread uses its own random engine.
+ */
+class AliasTable {
+public:
+	AliasTable()
+		: offset_(1, 0) {}
+
+	/**
+	Creates a table holding a single distribution.
+	*/
+	explicit AliasTable(const std::vector<double> &weights)
+		: offset_(1, 0) {
+		add(weights.data(), weights.size());
+	}
+
+	/**
+	Appends a distribution proportional to the given (non-negative) weights
+	and returns its index. If all weights are zero the distribution is uniform.
+	*/
+	int add(const double *weights, int n);
+
+	int numDistributions() const {return offset_.size() - 1;}
+	int size(int d = 0) const {return offset_[d+1] - offset_[d];}
+
+	/**
+	Returns an index in [0, size(d)) drawn from distribution d.
+	A single uniform draw selects both the bucket and the biased coin.
+	*/
+	template<class Engine>
+	int sample(Engine &r, int d = 0) const {
+		int begin = offset_[d];
+		int n = offset_[d+1] - begin;
+		std::uniform_real_distribution<double> u(0.0, n);
+		double x = u(r);
+		int k = static_cast<int>(x);
+		if(k >= n) {k = n - 1;}
+
+		return (x - k < prob_[begin + k]) ? k : alias_[begin + k];
+	}
+
+	/**
+	Probability of drawing index k from distribution d.
+	*/
+	double probability(int k, int d = 0) const;
+
+	size_t memoryBytes() const {
+		return prob_.capacity() * sizeof(double) + alias_.capacity() * sizeof(int)
+			+ offset_.capacity() * sizeof(int);
+	}
+
+private:
+	std::vector<double> prob_;
+	std::vector<int> alias_;
+	std::vector<int> offset_;
+};
+
+#endif
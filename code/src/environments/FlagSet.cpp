@@ -1,26 +1,33 @@
-#include <algorithm>
 #include "core/Platform.h"
 #include "environments/FlagSet.h"
 
 FlagSet::FlagSet(int numFlags) 
-	: numFlags(numFlags), numThreads(Platform::getNumLocalThreads()) {
-	numActive.reset(new int[numThreads]);
-	reset();
+	: numFlags(numFlags), numThreads(Platform::getNumLocalThreads()), epoch(1),
+	  stamps(new std::atomic<unsigned int>[numFlags]), numActive(numThreads) {
+	for(int i = 0; i < numFlags; ++i) {stamps[i].store(0, std::memory_order_relaxed);}
 }
 
 void FlagSet::reset() {
-	std::fill(numActive.get(), numActive.get() + numThreads, 0);
-	flags.reset(new SpinLock[numFlags]);
-}
+	for(int t = 0; t < numThreads; ++t) {numActive[t] = 0;}
 
-void FlagSet::set(int flag) {
-	if(!flags[flag].tryLock()) {
-		++numActive[Platform::getThreadId()];
+	if(++epoch == 0) {
+		//Stamps from 2^32 resets ago would look current
+		for(int i = 0; i < numFlags; ++i) {stamps[i].store(0, std::memory_order_relaxed);}
+		epoch = 1;
 	}
 }
 
-int FlagSet::getNumActive() const {
-	return std::accumulate(numActive.get(), numActive.get() + numThreads, 0);
-} 
+bool FlagSet::set(int flag) {
+	//Plain read first, so that flags set earlier in the epoch do not cost a write
+	if(stamps[flag].load(std::memory_order_relaxed) == epoch) {return false;}
+	if(stamps[flag].exchange(epoch, std::memory_order_relaxed) == epoch) {return false;}
 
+	++numActive[Platform::getThreadId()];
+	return true;
+}
 
+int FlagSet::getNumActive() const {
+	int sum = 0;
+	for(int t = 0; t < numThreads; ++t) {sum += numActive[t];}
+	return sum;
+}
@@ -1,21 +1,42 @@
 #ifndef _RCD_FLAGSET_H
 #define _RCD_FLAGSET_H
 
+#include <atomic>
 #include <memory>
-#include "core/SpinLock.h"
+#include "core/PaddedArray.h"
 
+/**
+ * Tracks which of a set of flags (e.g. variables) have been touched since the
+ * last reset. Safe to set concurrently from multiple threads.
+ *
+ * Each flag stores the epoch in which it was last set; a flag is set iff its
+ * stamp equals the current epoch, so reset() only advances the epoch and
+ * clears the per-thread counters. Counting is done per thread and summed
+ * only when getNumActive() is called, which costs O(threads).
+ */
 class FlagSet {
  public:
 	FlagSet(int numFlags);
-	void set(int flag);
+
+	/**
+	Sets a flag. Returns true if the flag was not already set.
+	*/
+	bool set(int flag);
+
+	/**
+	Clears all flags. Must not be called concurrently with set().
+	*/
 	void reset();
+
 	int getNumActive() const;
+	int getNumFlags() const {return numFlags;}
 
  private:
 	int numFlags;
 	int numThreads;
-	std::unique_ptr<SpinLock[]> flags;
-	std::unique_ptr<int[]> numActive;
+	unsigned int epoch;
+	std::unique_ptr<std::atomic<unsigned int>[]> stamps;
+	PaddedArray<int> numActive;
 };
 
 #endif
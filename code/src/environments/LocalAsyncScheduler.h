@@ -4,9 +4,11 @@
 #include <functional>
 #include "core/RCDNode.h"
 #include "core/RCDScheduler.h"
+#include "core/LockTable.h"
 #include "core/SpinLock.h"
 #include "environments/NetConfig.h"
 #include "environments/PairSelectionFunc.h"
+#include "environments/ThreadStats.h"
 
 typedef std::function<PairSelection *(int threadId, int numThreads)> PairSelectionFactory;
 
@@ -17,7 +19,15 @@ template <class InfoSpec, class Lock = SpinLock>
 	enum LockingLevel {
 		DOUBLE,
 		SINGLE,
-		LOCK_FREE
+		LOCK_FREE,
+		OPTIMISTIC	//Compute without locks, validate variable versions on commit and retry on conflict
+	};
+
+	//Values of the control word shared by the worker threads
+	enum ControlState {
+		RUNNING,
+		BLOCK_DONE,
+		STOPPED
 	};
 
  public:
@@ -49,23 +59,57 @@ template <class InfoSpec, class Lock = SpinLock>
 			delete selectors[i];
 		}
 
-		delete selectors;
+		delete[] selectors;
 	}
 
+	/**
+	 * Ends each convergence block after p updates (summed over threads), in addition
+	 * to ending it when all variables have been covered. Needed with selectors that
+	 * do not cover all variables (e.g. working set selection). Disabled by default.
+	 */
 	void setSyncPeriod(int p) {this->syncPeriod = p;}
 	void setLockingLevel(LockingLevel level) {this->locking = level;}
 
+	/**
+	 * Sets the number of locks shared by the variables. Variables are hashed
+	 * onto the given number of cache-line padded locks. A non-positive value
+	 * (the default) gives every variable its own lock.
+	 */
+	void setLockStripes(int numStripes) {this->lockStripes = numStripes;}
+
+	/**
+	 * Enables measuring the time spent in each phase of a pair update.
+	 * Timings are reported in OptOutput.propDouble. Disabled by default since
+	 * reading the clock several times per update is not free.
+	 */
+	void setCollectTimings(bool collect) {this->collectTimings = collect;}
+
+	/**
+	Binds each worker thread to a fixed CPU for the duration of solve().
+	*/
+	void setPinThreads(bool pin) {this->pinThreads = pin;}
+
  protected:
 	virtual OptOutput doSolve() OVERRIDE;
 
  private:
 	void construct(PairSelectionFactory &factory);
 
+	/**
+	Locks variables i and j, or only i if j is negative. Counts the failed
+	attempts in stats and traces the wait if the locks were held.
+	*/
+	void acquire(LockTable<Lock> &locks, int i, int j, ThreadStats &stats);
+
 	int numVars;
 	int numThreads;
 	int syncPeriod;
 	bool outputObjectiveTrace;
 	LockingLevel locking;
+	int lockStripes;
+	bool collectTimings;
+	bool pinThreads;
+	PairSelectionFactory selectorFactory;
 	PairSelection **selectors;
 };
 
@@ -4,160 +4,370 @@
 #include <atomic>
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <vector>
 
+#include "core/PaddedArray.h"
 #include "core/Platform.h"
 #include "environments/FlagSet.h"
 #include "environments/LocalAsyncScheduler.h"
 #include "environments/PairSelectionFunc.h"
+#include "environments/ThreadStats.h"
 
 template<class InfoSpec, class Lock>
 	void LocalAsyncScheduler<InfoSpec, Lock>::construct(PairSelectionFactory &factory) {
 	outputObjectiveTrace = true;
 	locking = SINGLE;
+	lockStripes = 0;
+	collectTimings = false;
+	pinThreads = false;
+	syncPeriod = -1;
 	numThreads = Platform::getNumLocalThreads();
+	selectorFactory = factory;
+
+	//Selectors are created by the worker threads that use them (see doSolve)
 	selectors = new PairSelection*[numThreads];
+	std::fill(selectors, selectors + numThreads, static_cast<PairSelection *>(0));
+}
 
-	#pragma omp parallel
-	{
-		int tid = Platform::getThreadId();
-		selectors[tid] = factory(tid, numThreads); 
-		assert(selectors[tid]->getBufferSize() == 1);
-	}
+template<class InfoSpec, class Lock>
+	void LocalAsyncScheduler<InfoSpec, Lock>::acquire(LockTable<Lock> &locks, int i, int j,
+			ThreadStats &stats) {
+	int64_t begin = this->trace_ ?this->trace_->now() :0;
+	int spins = (j >= 0) ?locks.lockPair(i, j) :locks.lock(i);
+	stats.addLockSpins(spins);
+	if(spins > 0 && this->trace_) {this->trace_->record("lock_wait", begin, i, j, true);}
 }
 
 template<class InfoSpec, class Lock>
 	OptOutput LocalAsyncScheduler<InfoSpec, Lock>::doSolve() {
 	OptOutput output;
 	int numVars = this->nodes_.size();
-	Lock locks[numVars];
-	int version[numVars];
+	LockTable<Lock> locks(numVars, lockStripes);
 
-	std::fill(version, version + numVars, 0);
+	//Versions are only needed to validate optimistic commits and to count
+	//collisions under SINGLE. Each gets its own cache line, since threads
+	//working on neighbouring variables would otherwise invalidate each other.
+	bool useVersions = (locking == OPTIMISTIC || locking == SINGLE);
+	PaddedArray<std::atomic<int> > version(useVersions ?numVars :0);
 	
-	if(syncPeriod > this->maxIterations_) {syncPeriod = this->maxIterations_;}
+	if(this->maxIterations_ > 0 && syncPeriod > this->maxIterations_) {syncPeriod = this->maxIterations_;}
 	double prevObj = std::numeric_limits<double>::infinity();
 
-	bool converged = false;
-	int numUpdates[numThreads]; std::fill(numUpdates, numUpdates + numThreads, 0);
-	int numCollisions[numThreads]; std::fill(numCollisions, numCollisions + numThreads, 0);
-	int numAscents[numThreads]; std::fill(numAscents, numAscents + numThreads, 0);
+	PaddedArray<ThreadStats> stats(numThreads);
+
+	//Threads add their update counts in batches, so that the iteration limit
+	//can be checked without reading the counters of other threads
+	const int flushPeriod = 256;
+	std::atomic<long long> totalUpdates(0);
+
+	//Each thread checks whether all variables have been covered once every coverageCheckPeriod updates
+	const int coverageCheckPeriod = 64;
 
 	FlagSet flags(numVars);
 
-	while(!converged) {
-		LOG("Iteration BLOCK");
-		bool convTest = false;
+	//Workers run pair updates while the control word is RUNNING. Any worker may end
+	//the block; the objective is then evaluated by one thread, which either starts
+	//the next block or stops the pool.
+	std::atomic<int> control(RUNNING);
+	int numBlocks = 0;
 
-		#pragma omp parallel shared(convTest)
-		{
-		int tid = Platform::getThreadId();
+	if(this->problem_) {this->problem_->beginBlock();}
+
+	//A block ends once every variable that selectors can draw has been updated,
+	//or after syncPeriod updates if a sync period is set
+	int coverageTarget = this->problem_ ?this->problem_->numActiveVars() :numVars;
+	long long blockEnd = (syncPeriod > 0) ?syncPeriod :std::numeric_limits<long long>::max();
+	int flushEvery = flushPeriod;
+	if(syncPeriod > 0) {flushEvery = std::max(1, std::min(flushPeriod, syncPeriod / numThreads));}
+
+	//A single parallel region spans all blocks, so each thread keeps its selector
+	//and its share of the lock and stats arrays for the whole run
+	#pragma omp parallel num_threads(numThreads)
+	{
+	int tid = Platform::getThreadId();
+	if(pinThreads) {Platform::pinCurrentThread(tid);}
 
-		while(!convTest) {		  	
+	if(!selectors[tid]) {
+		selectors[tid] = selectorFactory(tid, numThreads);
+		assert(selectors[tid]->getBufferSize() == 1);
+	}
+
+	PairSelection *selector = selectors[tid];
+	ThreadStats &threadStats = stats[tid];
+
+	while(true) {
+		int pendingUpdates = 0;
+		int64_t blockBegin = this->trace_ ?this->trace_->now() :0;
+
+		while(control.load(std::memory_order_relaxed) == RUNNING) {
 			int i, j, n;
 			//double objOld = 0.0;
 			//double objNew = 0.0;
 			
-			selectors[tid]->getPairs(&i, &j, n);
+			selector->getPairs(&i, &j, n);
 			assert(i != j);
+			TraceScope tracePair(this->trace_, "pair_update", i, j, true);
 
 			int id1 = (i < j) ?i :j;
 			int id2 = (i < j) ?j :i;
 
-			//To avoid deadlocks, always lock the node with the smallest id first
-			if(locking == DOUBLE) {locks[id1].lock(); locks[id2].lock(); }
-
-			if(locking == SINGLE) {locks[i].lock();}
-			int versionOld = version[i];
+			if(locking == OPTIMISTIC) {
+				//Compute without locks, then commit only if neither version changed.
+				//A version is odd while a commit to its variable is in progress.
+				int waited = 0;
+
+				while(true) {
+					int v1 = version[id1].load(std::memory_order_acquire);
+					int v2 = version[id2].load(std::memory_order_acquire);
+					if((v1 | v2) & 1) {
+						Platform::spinWait(waited++);
+						continue;
+					}
+
+					PhaseTimer timer(collectTimings);
+					PhaseHistogramTimer hist(threadStats);
+					NodeInput input_i; this->readClient_->getNodeInput(i, input_i);
+					NodeInput input_j; this->readClient_->getNodeInput(j, input_j);
+					threadStats.readTime += timer.lap();
+					hist.lap(ThreadStats::PHASE_READ);
+					MasterInfo info_i = this->nodes_[i]->getInfoAsMaster(j, input_i);
+					threadStats.masterTime += timer.lap();
+					hist.lap(ThreadStats::PHASE_MASTER);
+					SlaveInfo info_j;
+					Update update_j;
+					this->nodes_[j]->updateAsSlave(i, info_i, input_j, info_j, update_j);
+					threadStats.slaveTime += timer.lap();
+					hist.lap(ThreadStats::PHASE_SLAVE);
+					Update update_i;
+					this->nodes_[i]->updateAsMaster(info_i, j, info_j, update_i);
+					threadStats.masterTime += timer.lap();
+					hist.lap(ThreadStats::PHASE_MASTER);
+
+					//Odd versions give this thread exclusive ownership of both
+					//variables, so the client can skip its own locks
+					if(version[id1].compare_exchange_strong(v1, v1 + 1,
+							std::memory_order_acquire, std::memory_order_relaxed)) {
+						if(version[id2].compare_exchange_strong(v2, v2 + 1,
+								std::memory_order_acquire, std::memory_order_relaxed)) {
+							this->updateClient_->updateExclusive(i, j, update_i, update_j, false);
+							version[id2].store(v2 + 2, std::memory_order_release);
+							version[id1].store(v1 + 2, std::memory_order_release);
+							threadStats.updateTime += timer.lap();
+							hist.lap(ThreadStats::PHASE_UPDATE);
+							break;
+						}
+
+						version[id1].store(v1, std::memory_order_release);
+					}
+
+					++threadStats.numRetries;
+				}
+			} else {
+				PhaseHistogramTimer hist(threadStats);
+
+				//To avoid deadlocks, the lock table acquires both locks in a fixed order
+				if(locking == DOUBLE) {
+					acquire(locks, id1, id2, threadStats);
+					hist.lap(ThreadStats::PHASE_LOCK);
+				}
+
+				if(locking == SINGLE) {
+					acquire(locks, i, -1, threadStats);
+					hist.lap(ThreadStats::PHASE_LOCK);
+				}
+				//Versions only change while the variable's lock is held
+				int versionOld = (locking == SINGLE) ?version[i].load(std::memory_order_relaxed) :0;
+
+				PhaseTimer timer(collectTimings);
+				NodeInput input_i; this->readClient_->getNodeInput(i, input_i);
+				threadStats.readTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_READ);
+				MasterInfo info_i = this->nodes_[i]->getInfoAsMaster(j, input_i);
+				threadStats.masterTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_MASTER);
+				//Platform::sleepCurrentThread(50);
+				if(locking == SINGLE) {locks.unlock(i);}
+
+				if(locking == SINGLE) {
+					hist.skip();
+					acquire(locks, j, -1, threadStats);
+					hist.lap(ThreadStats::PHASE_LOCK);
+				}
+
+				SlaveInfo info_j;
+				Update update_j;		
+				timer.lap();
+				NodeInput input_j; this->readClient_->getNodeInput(j, input_j);
+				threadStats.readTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_READ);
+				this->nodes_[j]->updateAsSlave(i, info_i, input_j, info_j, update_j);
+				threadStats.slaveTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_SLAVE);
+				//Platform::sleepCurrentThread(50); <-- Important
+
+				if(locking == SINGLE) {
+					this->updateClient_->update(j, -1, update_j, update_j, false);
+					threadStats.updateTime += timer.lap();
+					hist.lap(ThreadStats::PHASE_UPDATE);
+				}
+
+				if(locking == SINGLE) {locks.unlock(j);}
+
+				if(locking == SINGLE) {
+					hist.skip();
+					acquire(locks, i, -1, threadStats);
+					hist.lap(ThreadStats::PHASE_LOCK);
+				}
+				int versionNew = 0;
+				if(locking == SINGLE) {
+					versionNew = version[i].load(std::memory_order_relaxed);
+					version[i].store(versionNew + 1, std::memory_order_relaxed);
+				}
+				Update update_i;
+				timer.lap();
+				this->nodes_[i]->updateAsMaster(info_i, j, info_j, update_i);
+				threadStats.masterTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_MASTER);
+
+				if(locking == SINGLE) {
+					this->updateClient_->update(i, -1, update_i, update_i, false);
+				} else {
+					this->updateClient_->update(i, j, update_i, update_j, locking == LOCK_FREE);
+				}
+
+				threadStats.updateTime += timer.lap();
+				hist.lap(ThreadStats::PHASE_UPDATE);
+
+				if(locking == SINGLE) {locks.unlock(i);}
+
+				if(locking == DOUBLE) {locks.unlockPair(id1, id2);}
+
+				//Make sense only when locking level is single
+				if(versionNew != versionOld) {
+					++threadStats.numCollisions;
+				}
+			}
 
-			NodeInput input_i; this->readClient_->getNodeInput(i, input_i);
-			MasterInfo info_i = this->nodes_[i]->getInfoAsMaster(j, input_i);
-			//Platform::sleepCurrentThread(50);
-			if(locking == SINGLE) {locks[i].unlock();}
+			++threadStats.numUpdates;
+			flags.set(i); flags.set(j);
 
-			if(locking == SINGLE) {locks[j].lock();}
+			if(++pendingUpdates == flushEvery) {
+				long long total = totalUpdates.fetch_add(pendingUpdates) + pendingUpdates;
+				pendingUpdates = 0;
+				if(tid == 0 && total % 1024 < flushEvery) {LOG(total);}
 
-			SlaveInfo info_j;
-			Update update_j;		
-			NodeInput input_j; this->readClient_->getNodeInput(j, input_j);
-			this->nodes_[j]->updateAsSlave(i, info_i, input_j, info_j, update_j);
-			//Platform::sleepCurrentThread(50); <-- Important
+				if((this->maxIterations_ > 0 && total > this->maxIterations_) || total >= blockEnd) {
+					control.store(BLOCK_DONE, std::memory_order_relaxed);
+				}
+			}
 
-			if(locking == SINGLE) {
-				this->updateClient_->update(j, -1, update_j, update_j, false);
+			if(threadStats.numUpdates % coverageCheckPeriod == 0
+			   && flags.getNumActive() >= coverageTarget) {
+				control.store(BLOCK_DONE, std::memory_order_relaxed);
 			}
 
-			if(locking == SINGLE) {locks[j].unlock();}
+			//if(objNew > objOld) {
+			//	++threadStats.numAscents;
+			//}
+		}
 
-			if(locking == SINGLE) {locks[i].lock();}
-			int versionNew = version[i]++;
-			Update update_i;
-			this->nodes_[i]->updateAsMaster(info_i, j, info_j, update_i);
+		totalUpdates += pendingUpdates;
+		if(this->trace_) {this->trace_->record("block", blockBegin, numBlocks);}
 
-			if(locking == SINGLE) {
-				this->updateClient_->update(i, -1, update_i, update_i, false);
-			} else {
-				this->updateClient_->update(i, j, update_i, update_j, locking == LOCK_FREE);
+		//Wait for all updates of the block to finish before evaluating the objective
+		{
+			TraceScope traceWait(this->trace_, "barrier_wait");
+			#pragma omp barrier
+		}
+
+		if(this->problem_) {
+			{
+				TraceScope traceRefresh(this->trace_, "refresh_state");
+				this->problem_->refreshState(numBlocks, tid, numThreads);
 			}
 
-			if(locking == SINGLE) {locks[i].unlock();}
+			TraceScope traceWait(this->trace_, "barrier_wait");
+			#pragma omp barrier
+		}
 
-			if(locking == DOUBLE) {locks[id2].unlock(); locks[id1].unlock(); }
+		#pragma omp single nowait
+		{
+			++numBlocks;
+			flags.reset();
 
-			++numUpdates[tid];
-			flags.set(i); flags.set(j);
-			if(tid == 0 && numUpdates[tid] % 1000 == 0) {
-				int totalUpdates = std::accumulate(numUpdates, numUpdates + numThreads, 0);
-				LOG(totalUpdates);
+			//Compute objective
+			LOG(totalUpdates << " Conv test");
+			double sum = 0.0;
 
-				if(this->maxIterations_ > 0 && totalUpdates > this->maxIterations_) {convTest = true;}
+			if(this->problem_) {
+				TraceScope traceObjective(this->trace_, "compute_objective");
+				sum = this->problem_->computeObjective();
 			}
 
-			if(flags.getNumActive() == numVars) {convTest = true;}
-
-			//Make sense only when locking level is single
-			if(versionNew != versionOld) {
-				++numCollisions[tid];
+			bool converged = false;
+
+			if(this->maxIterations_ > 0 && totalUpdates > this->maxIterations_) {
+				converged = true;
+				LOG("Converged");
+			} else if(this->withinTolerance(prevObj, sum) || sum < this->minObj_) {
+				//Variables removed by shrinking must be checked before stopping
+				if(this->problem_ && this->problem_->restoreInactive()) {
+					LOG("Restored inactive variables");
+					prevObj = std::numeric_limits<double>::infinity();
+				} else {
+					converged = true;
+					LOG("Converged");
+				}
+			} else {prevObj = sum;}
+
+			if(this->problem_) {
+				//beginBlock may shrink the active set
+				if(!converged) {this->problem_->beginBlock();}
+				coverageTarget = this->problem_->numActiveVars();
 			}
-			//if(objNew > objOld) {
-			//	++numAscents[tid];
-			//}
-		}
-		LOG(tid << "done");		
-	
-		}		
 
-		flags.reset();
+			if(syncPeriod > 0) {blockEnd = totalUpdates + syncPeriod;}
 
-		//Compute objective
-		int totalUpdates = std::accumulate(numUpdates, numUpdates + numThreads, 0);
-		LOG(totalUpdates << " Conv test");
-		double sum = 0.0;
+			if(outputObjectiveTrace && this->iterationListener_) {
+				this->iterationListener_(totalUpdates, this->getElapsedTime(), sum);
+			}
 
-		if(this->problem_) {
-			sum = this->problem_->computeObjective();
+			control.store(converged ?STOPPED :RUNNING, std::memory_order_relaxed);
 		}
 
-		if((this->eps_ > 0.0 && fabs(prevObj - sum) < this->eps_)
-		   || sum < this->minObj_
-		   || (this->maxIterations_ > 0 && totalUpdates > this->maxIterations_)) {
-			converged = true;
-			LOG("Converged");
-		} else {prevObj = sum;}
-
-		if(outputObjectiveTrace && this->iterationListener_) {
-			this->iterationListener_(totalUpdates, this->getElapsedTime(), sum);
+		//The barrier publishes the new control word
+		{
+			TraceScope traceWait(this->trace_, "barrier_wait");
+			#pragma omp barrier
 		}
+
+		if(control.load(std::memory_order_relaxed) == STOPPED) {break;}
+	}
+
+	LOG(tid << "done");
+
+	//Pinning only applies to this solve
+	if(pinThreads) {Platform::unpinCurrentThread();}
 	}
 
 	LOG("Finished");
 	
 	//Compute objective
 	double finalObjective = 0.0;
-	if(this->problem_) {finalObjective = this->problem_->computeObjective();}
+	if(this->problem_) {
+		TraceScope traceObjective(this->trace_, "compute_objective");
+		finalObjective = this->problem_->computeObjective();
+	}
 	output.objective = finalObjective;
-	output.numIterations = std::accumulate(numUpdates, numUpdates + numThreads, 0);
-	output.propInt["collisions"] = std::accumulate(numCollisions, numCollisions + numThreads, 0);
-	output.propInt["ascents"] = std::accumulate(numAscents, numAscents + numThreads, 0);
+	output.numIterations = totalUpdates;
+
+	ThreadStats::merge(stats).report(output, collectTimings);
+	output.propInt["blocks"] = numBlocks;
+	output.propInt["lock_stripes"] = locks.numLocks();
+	output.propDouble["lock_contentions"] = static_cast<double>(locks.getNumContentions());
+	output.propDouble["lock_table_bytes"] = static_cast<double>(locks.memoryBytes());
+	output.propDouble["version_bytes"] = static_cast<double>(version.memoryBytes());
 	return output;
 }
 
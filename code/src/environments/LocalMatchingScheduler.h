@@ -0,0 +1,104 @@
+#ifndef _RCD_LOCALMATCHINGSCHEDULER_H_
+#define _RCD_LOCALMATCHINGSCHEDULER_H_
+
+#include <memory>
+#include <vector>
+#include "core/FastRandom.h"
+#include "core/RCDNode.h"
+#include "core/RCDScheduler.h"
+#include "environments/MatchingSampler.h"
+#include "environments/NetConfig.h"
+
+/**
+ * Bulk-synchronous scheduler. Work proceeds in rounds: each round draws a
+ * matching, i.e. a set of pairs in which no variable appears twice, and the
+ * threads update its pairs in parallel without any locks. Rounds are
+ * separated by barriers. While the threads work on a round, the master
+ * thread draws the next one before joining them, so sampling overlaps with
+ * the updates. If the problem shrinks its active set, rounds only pair
+ * active variables.
+ *
+ * Pairs are handed to the update client as exclusive updates, and with more
+ * than one thread the scheduler requests atomic updates of state shared by
+ * all variables (e.g. the SVM gradient). The sequence of pairs depends only
+ * on the seed, so problems without such shared state give the same result on
+ * every run; with it, the order of the atomic adds (and thus rounding) may
+ * still vary between runs.
+ */
+template <class InfoSpec>
+	class LocalMatchingScheduler : public RCDLocalScheduler<InfoSpec> {
+	typedef RCDLocalScheduler<InfoSpec> Super;
+ public:
+	typedef typename Super::MasterInfo MasterInfo;
+	typedef typename Super::SlaveInfo SlaveInfo;
+	typedef typename Super::Update Update;
+	typedef typename Super::NodeInput NodeInput;
+
+	/**
+	Pairs are edges of the given communication graph.
+	*/
+	LocalMatchingScheduler(const NetConfig *config, int seed = 0)
+		: sampler(new MatchingSampler(config)), r(seed) {
+		construct();
+	}
+
+	/**
+	Any two variables can form a pair. Matchings are drawn from a random
+	permutation, so the clique is never built.
+	*/
+	LocalMatchingScheduler(int numVars, int seed = 0)
+		: r(seed) {
+		construct();
+	}
+
+	/**
+	 * Sets the number of pairs per round. A non-positive value (the default)
+	 * uses maximal matchings, i.e. as many pairs as the graph allows.
+	 */
+	void setRoundSize(int numPairs) {this->roundSize = numPairs;}
+
+	/**
+	 * Tests for convergence once at least p pairs have been updated since the
+	 * last test (rounds are never split). By default p is the number of active
+	 * variables, so every variable is updated twice per block on average.
+	 */
+	void setSyncPeriod(int p) {this->syncPeriod = p;}
+
+	void setCollectTimings(bool collect) {this->collectTimings = collect;}
+	void setPinThreads(bool pin) {this->pinThreads = pin;}
+
+ protected:
+	virtual OptOutput doSolve() OVERRIDE;
+
+ private:
+	void construct();
+
+	/**
+	Draws the pairs of the next round, returns their number.
+	*/
+	int sampleRound(int numVars, int out_i[], int out_j[]);
+
+	/**
+	Restricts the following rounds to the problem's active variables. Called
+	at the start of every block, once the active set is final.
+	*/
+	void restrictToActive(int numVars);
+
+	//Pairs handed out at a time, so that the master can join a round late
+	static const int PAIRS_PER_CHUNK = 64;
+
+	int numThreads;
+	int roundSize;
+	int syncPeriod;
+	bool collectTimings;
+	bool pinThreads;
+
+	std::unique_ptr<MatchingSampler> sampler; //Null for the clique
+	std::vector<int> perm; //Active variables, shuffled for the clique
+	std::vector<int> inactive; //Excluded from the sampler's matchings
+	Xoshiro256 r;
+};
+
+#include "LocalMatchingScheduler_Impl.h"
+
+#endif
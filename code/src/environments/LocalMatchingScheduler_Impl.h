@@ -0,0 +1,252 @@
+#ifndef _RCD_LOCALMATCHINGSCHEDULERIMPL_H_
+#define _RCD_LOCALMATCHINGSCHEDULERIMPL_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "core/Platform.h"
+#include "environments/LocalMatchingScheduler.h"
+#include "environments/ThreadStats.h"
+
+template<class InfoSpec>
+	void LocalMatchingScheduler<InfoSpec>::construct() {
+	numThreads = Platform::getNumLocalThreads();
+	roundSize = -1;
+	syncPeriod = -1;
+	collectTimings = false;
+	pinThreads = false;
+}
+
+template<class InfoSpec>
+	int LocalMatchingScheduler<InfoSpec>::sampleRound(int numVars, int out_i[], int out_j[]) {
+	//Without a limit sampleRandom returns a maximal matching built in random
+	//order. A cyclic scan (sampleCovering) would keep producing the same few
+	//matchings on sparse graphs, and repeating a matching makes no progress
+	//once its pair subproblems are solved.
+	if(sampler) {
+		return sampler->sampleRandom((roundSize > 0) ?roundSize :numVars, r, out_i, out_j);
+	}
+
+	//Partial Fisher-Yates shuffle: consecutive entries of perm form the pairs
+	int numActive = perm.size();
+	int numPairs = numActive / 2;
+	if(roundSize > 0 && roundSize < numPairs) {numPairs = roundSize;}
+
+	for(int k = 0; k < 2 * numPairs; k++) {
+		int pick = k + r.bounded(numActive - k);
+		std::swap(perm[k], perm[pick]);
+	}
+
+	for(int p = 0; p < numPairs; p++) {
+		out_i[p] = perm[2*p];
+		out_j[p] = perm[2*p + 1];
+	}
+
+	return numPairs;
+}
+
+template<class InfoSpec>
+	void LocalMatchingScheduler<InfoSpec>::restrictToActive(int numVars) {
+	const ActiveSet *activeSet = this->problem_ ?this->problem_->activeSet() :0;
+
+	if(sampler) {
+		inactive.clear();
+		if(activeSet) {
+			for(int v = 0; v < numVars; v++) {
+				if(!activeSet->isActive(v)) {inactive.push_back(v);}
+			}
+		}
+
+		sampler->setExcluded(inactive);
+	} else if(activeSet) {
+		perm.resize(activeSet->size());
+		for(int k = 0; k < activeSet->size(); k++) {perm[k] = (*activeSet)[k];}
+	} else if(static_cast<int>(perm.size()) != numVars) {
+		perm.resize(numVars);
+		std::iota(perm.begin(), perm.end(), 0);
+	}
+}
+
+template<class InfoSpec>
+	OptOutput LocalMatchingScheduler<InfoSpec>::doSolve() {
+	OptOutput output;
+	int numVars = this->nodes_.size();
+	assert(!sampler || sampler->numVars() == numVars);
+
+	//Double buffered: the next round is drawn while the current one runs
+	int maxPairs = numVars / 2;
+	if(sampler && roundSize > 0) {maxPairs = roundSize;}
+	std::vector<int> buffer_i[2], buffer_j[2];
+	for(int b = 0; b < 2; b++) {
+		buffer_i[b].resize(maxPairs);
+		buffer_j[b].resize(maxPairs);
+	}
+
+	int *pair_i = buffer_i[0].data();
+	int *pair_j = buffer_j[0].data();
+	int *next_i = buffer_i[1].data();
+	int *next_j = buffer_j[1].data();
+	int nextNumPairs = 0;
+	bool lastRound = false;
+
+	PaddedArray<ThreadStats> stats(numThreads);
+	double prevObj = std::numeric_limits<double>::infinity();
+	long long totalUpdates = 0;
+	long long blockUpdates = 0;
+	int numBlocks = 0;
+	long long numRounds = 0;
+	bool blockDone = false;
+	bool stopped = false;
+
+	auto blockLength = [&] () -> long long {
+		if(syncPeriod > 0) {return syncPeriod;}
+		return std::max(1, this->problem_ ?this->problem_->numActiveVars() :numVars);
+	};
+
+	if(this->problem_) {this->problem_->beginBlock();}
+	restrictToActive(numVars);
+	long long blockEnd = blockLength();
+	int numPairs = sampleRound(numVars, pair_i, pair_j);
+
+	#pragma omp parallel num_threads(numThreads)
+	{
+	int tid = Platform::getThreadId();
+	if(pinThreads) {Platform::pinCurrentThread(tid);}
+	ThreadStats &threadStats = stats[tid];
+
+	while(true) {
+		//The master draws the next round unless this one ends the block (whose
+		//beginBlock may change the active set), and then joins the loop late.
+		//The draws happen in the same order as without overlap.
+		#pragma omp master
+		{
+			//A round without pairs (active variables without active
+			//neighbours) ends the block, so that shrinking can be undone
+			lastRound = numPairs == 0 || blockUpdates + numPairs >= blockEnd
+				|| (this->maxIterations_ > 0 && totalUpdates + numPairs > this->maxIterations_);
+
+			if(!lastRound) {
+				TraceScope traceSample(this->trace_, "sample_round");
+				nextNumPairs = sampleRound(numVars, next_i, next_j);
+			}
+		}
+
+		//The pairs of a round are disjoint, so no locks are needed, but state
+		//shared by all variables must still be updated atomically
+		#pragma omp for schedule(dynamic, PAIRS_PER_CHUNK)
+		for(int p = 0; p < numPairs; p++) {
+			int i = pair_i[p];
+			int j = pair_j[p];
+			TraceScope tracePair(this->trace_, "pair_update", i, j, true);
+
+			PhaseTimer timer(collectTimings);
+			NodeInput input_i; this->readClient_->getNodeInput(i, input_i);
+			threadStats.readTime += timer.lap();
+			MasterInfo info_i = this->nodes_[i]->getInfoAsMaster(j, input_i);
+			threadStats.masterTime += timer.lap();
+
+			SlaveInfo info_j;
+			Update update_j;
+			NodeInput input_j; this->readClient_->getNodeInput(j, input_j);
+			threadStats.readTime += timer.lap();
+			this->nodes_[j]->updateAsSlave(i, info_i, input_j, info_j, update_j);
+			threadStats.slaveTime += timer.lap();
+
+			Update update_i;
+			this->nodes_[i]->updateAsMaster(info_i, j, info_j, update_i);
+			threadStats.masterTime += timer.lap();
+			this->updateClient_->updateExclusive(i, j, update_i, update_j, numThreads > 1);
+			threadStats.updateTime += timer.lap();
+
+			++threadStats.numUpdates;
+		}
+
+		//The implicit barrier of the loop ends the round
+		#pragma omp single
+		{
+			++numRounds;
+			totalUpdates += numPairs;
+			blockUpdates += numPairs;
+			blockDone = lastRound;
+
+			if(!blockDone) {
+				std::swap(pair_i, next_i);
+				std::swap(pair_j, next_j);
+				numPairs = nextNumPairs;
+			}
+		}
+
+		if(!blockDone) {continue;}
+
+		if(this->problem_) {
+			{
+				TraceScope traceRefresh(this->trace_, "refresh_state");
+				this->problem_->refreshState(numBlocks, tid, numThreads);
+			}
+
+			#pragma omp barrier
+		}
+
+		#pragma omp single
+		{
+			++numBlocks;
+			blockUpdates = 0;
+
+			LOG(totalUpdates << " Conv test");
+			double sum = 0.0;
+			if(this->problem_) {
+				TraceScope traceObjective(this->trace_, "compute_objective");
+				sum = this->problem_->computeObjective();
+			}
+
+			if(this->maxIterations_ > 0 && totalUpdates > this->maxIterations_) {
+				stopped = true;
+				LOG("Converged");
+			} else if(this->withinTolerance(prevObj, sum) || sum < this->minObj_) {
+				//Variables removed by shrinking must be checked before stopping
+				if(this->problem_ && this->problem_->restoreInactive()) {
+					LOG("Restored inactive variables");
+					prevObj = std::numeric_limits<double>::infinity();
+				} else {
+					stopped = true;
+					LOG("Converged");
+				}
+			} else {prevObj = sum;}
+
+			if(this->iterationListener_) {
+				this->iterationListener_(totalUpdates, this->getElapsedTime(), sum);
+			}
+
+			if(!stopped) {
+				if(this->problem_) {this->problem_->beginBlock();}
+				restrictToActive(numVars);
+				blockEnd = blockLength();
+				numPairs = sampleRound(numVars, pair_i, pair_j);
+			}
+		}
+
+		if(stopped) {break;}
+	}
+
+	//Pinning only applies to this solve
+	if(pinThreads) {Platform::unpinCurrentThread();}
+	}
+
+	LOG("Finished");
+
+	double finalObjective = 0.0;
+	if(this->problem_) {finalObjective = this->problem_->computeObjective();}
+	output.objective = finalObjective;
+	output.numIterations = totalUpdates;
+
+	ThreadStats::merge(stats).report(output, collectTimings);
+	output.propInt["blocks"] = numBlocks;
+	output.propDouble["rounds"] = static_cast<double>(numRounds);
+	output.propDouble["pairs_per_round"] = numRounds > 0 ?totalUpdates / static_cast<double>(numRounds) :0.0;
+	return output;
+}
+
+#endif
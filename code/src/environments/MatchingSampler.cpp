@@ -0,0 +1,152 @@
+#include <cassert>
+#include <algorithm>
+#include "environments/MatchingSampler.h"
+
+using namespace std;
+
+MatchingSampler::MatchingSampler(const NetConfig *config)
+	: numVars_(config->numVars), adjStart_(config->numVars + 1), live_(config->numVars)
+	, touchedEpoch_(config->numVars, 0), matchedEpoch_(config->numVars, 0), epoch_(0)
+	, pool_(config->numVars), poolPos_(config->numVars), poolSize_(0) {
+	adjStart_[0] = 0;
+	for(int v = 0; v < numVars_; v++) {
+		const vector<int> &neighbors = config->adjMatrix[v];
+		adj_.insert(adj_.end(), neighbors.begin(), neighbors.end());
+		adjStart_[v+1] = adj_.size();
+		live_[v] = neighbors.size();
+		pool_[v] = poolPos_[v] = v;
+	}
+
+	reset();
+}
+
+void MatchingSampler::reset() {
+	for(int v : touched_) {live_[v] = adjStart_[v+1] - adjStart_[v];}
+	touched_.clear();
+
+	//Stamps are only cleared when the epoch wraps around
+	if(++epoch_ == 0) {
+		std::fill(touchedEpoch_.begin(), touchedEpoch_.end(), 0);
+		std::fill(matchedEpoch_.begin(), matchedEpoch_.end(), 0);
+		epoch_ = 1;
+	}
+
+	//The pool is a permutation of all vertices, so it only needs resizing
+	poolSize_ = numVars_;
+
+	for(int v : excluded_) {
+		matchedEpoch_[v] = epoch_;
+		removeFromPool(v);
+	}
+}
+
+int MatchingSampler::matchNeighbor(int v, Xoshiro256 &r) {
+	assert(!isMatched(v));
+	int *neighbors = &adj_[adjStart_[v]];
+
+	while(live_[v] > 0) {
+		int k = r.bounded(live_[v]);
+		int u = neighbors[k];
+
+		if(!isMatched(u)) {
+			match(v, u);
+			return u;
+		}
+
+		//Move the matched neighbour to the dead suffix
+		if(touchedEpoch_[v] != epoch_) {
+			touchedEpoch_[v] = epoch_;
+			touched_.push_back(v);
+		}
+
+		int last = --live_[v];
+		neighbors[k] = neighbors[last];
+		neighbors[last] = u;
+	}
+
+	return -1;
+}
+
+int MatchingSampler::sampleRandom(int numPairs, Xoshiro256 &r, int out_i[], int out_j[]) {
+	reset();
+	int n = 0;
+
+	while(n < numPairs && poolSize_ > 0) {
+		int vi = pool_[r.bounded(poolSize_)];
+		int vj = matchNeighbor(vi, r);
+
+		if(vj < 0) {
+			removeFromPool(vi);
+			continue;
+		}
+
+		out_i[n] = vi;
+		out_j[n++] = vj;
+	}
+
+	return n;
+}
+
+int MatchingSampler::sampleCovering(int start, Xoshiro256 &r, int out_i[], int out_j[]) {
+	reset();
+	int n = 0;
+
+	for(int k = 0; k < numVars_; k++) {
+		int vi = start + k;
+		if(vi >= numVars_) {vi -= numVars_;}
+		if(isMatched(vi)) {continue;}
+
+		int vj = matchNeighbor(vi, r);
+		if(vj < 0) {continue;}
+
+		out_i[n] = vi;
+		out_j[n++] = vj;
+	}
+
+	return n;
+}
+
+int MatchingSampler::sampleBatches(int numBatches, int batchSize, bool covering, Xoshiro256 &r,
+		int out_i[], int out_j[], int batchSizes[]) {
+	int capacity = numBatches * batchSize;
+	int size = std::max(capacity, numVars_ / 2);
+	if(static_cast<int>(scratch_i_.size()) < size) {
+		scratch_i_.resize(size);
+		scratch_j_.resize(size);
+	}
+
+	int n;
+	if(covering) {
+		n = sampleCovering(r.bounded(numVars_), r, scratch_i_.data(), scratch_j_.data());
+		n = std::min(n, capacity);
+	} else {
+		n = sampleRandom(capacity, r, scratch_i_.data(), scratch_j_.data());
+	}
+
+	std::fill(batchSizes, batchSizes + numBatches, 0);
+	for(int p = 0; p < n; p++) {
+		int b = p % numBatches;
+		int slot = b * batchSize + batchSizes[b]++;
+		out_i[slot] = scratch_i_[p];
+		out_j[slot] = scratch_j_[p];
+	}
+
+	return n;
+}
+
+void MatchingSampler::match(int vi, int vj) {
+	matchedEpoch_[vi] = matchedEpoch_[vj] = epoch_;
+	removeFromPool(vi);
+	removeFromPool(vj);
+}
+
+void MatchingSampler::removeFromPool(int v) {
+	int pos = poolPos_[v];
+	if(pos >= poolSize_) {return;}
+
+	int last = pool_[--poolSize_];
+	pool_[pos] = last;
+	poolPos_[last] = pos;
+	pool_[poolSize_] = v;
+	poolPos_[v] = poolSize_;
+}
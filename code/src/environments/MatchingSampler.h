@@ -0,0 +1,97 @@
+#ifndef _RCD_MATCHINGSAMPLER_H_
+#define _RCD_MATCHINGSAMPLER_H_
+
+#include <vector>
+#include "core/FastRandom.h"
+#include "environments/NetConfig.h"
+
+/**
+ * Samples random matchings (sets of pairwise disjoint edges) of a NetConfig.
+ *
+ * The adjacency lists are stored once in CSR form. Within a matching each
+ * list is split into a live prefix and a dead suffix. Matched neighbours are
+ * moved to the dead suffix lazily, with an O(1) swap, when they are drawn.
+ * Vertices that can still be drawn are kept in a pool with position indices,
+ * so removing one is O(1) as well.
+ *
+ * The cost of a matching is therefore proportional to the number of edges
+ * inspected, not O(numVars * degree). All scratch state is reused across
+ * calls: starting a new matching only resets the vertices touched by the
+ * previous one.
+ */
+class MatchingSampler {
+public:
+	MatchingSampler(const NetConfig *config);
+
+	int numVars() const {return numVars_;}
+
+	/**
+	Leaves the given vertices out of all following matchings (e.g. variables
+	removed by shrinking). Replaces any previous exclusion.
+	*/
+	void setExcluded(const std::vector<int> &vertices) {excluded_ = vertices;}
+
+	/**
+	Starts a new matching in which all vertices are unmatched, except for the
+	excluded ones, which count as matched.
+	*/
+	void reset();
+
+	bool isMatched(int v) const {return matchedEpoch_[v] == epoch_;}
+
+	/**
+	Matches v (which must be unmatched) to a uniformly random unmatched
+	neighbour and returns it, or returns -1 if v has no unmatched neighbour.
+	*/
+	int matchNeighbor(int v, Xoshiro256 &r);
+
+	/**
+	Starts a new matching and adds up to numPairs pairs to it, choosing i
+	uniformly among the vertices that still have unmatched neighbours and j
+	uniformly among those neighbours. Returns the number of pairs found.
+	*/
+	int sampleRandom(int numPairs, Xoshiro256 &r, int out_i[], int out_j[]);
+
+	/**
+	Starts a new matching and scans the vertices in cyclic order from start,
+	matching every unmatched vertex to a random unmatched neighbour.
+	The result is a maximal matching. Returns the number of pairs.
+	*/
+	int sampleCovering(int start, Xoshiro256 &r, int out_i[], int out_j[]);
+
+	/**
+	Builds a matching with up to numBatches * batchSize pairs and deals it out
+	round-robin, so that all batches are disjoint. Pairs of batch b are stored
+	at out_i[b * batchSize ...] and their number in batchSizes[b].
+	If covering is true the matching is maximal (pairs beyond the batches'
+	capacity are dropped), otherwise it is drawn as in sampleRandom.
+	Returns the total number of pairs.
+	*/
+	int sampleBatches(int numBatches, int batchSize, bool covering, Xoshiro256 &r,
+			int out_i[], int out_j[], int batchSizes[]);
+
+private:
+	void match(int vi, int vj);
+	void removeFromPool(int v);
+
+	int numVars_;
+	std::vector<int> adjStart_;
+	std::vector<int> adj_;
+
+	//Per-matching state
+	std::vector<int> live_; //Number of live entries at the front of each adjacency list
+	std::vector<int> touched_; //Vertices whose live_ entry changed
+	std::vector<unsigned> touchedEpoch_;
+	std::vector<unsigned> matchedEpoch_;
+	unsigned epoch_;
+	std::vector<int> excluded_;
+
+	std::vector<int> pool_; //Vertices that can still be drawn are pool_[0...poolSize_-1]
+	std::vector<int> poolPos_;
+	int poolSize_;
+
+	std::vector<int> scratch_i_;
+	std::vector<int> scratch_j_;
+};
+
+#endif
@@ -1,174 +1,356 @@
 #include <cassert>
+#include <climits>
 #include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <string>
 #include "environments/PairSelectionFunc.h"
 
 using namespace std;
 
-void RandomSinglePair::getPair(int &vi, int &vj) {	
-	std::uniform_int_distribution<int> ui(0, numVars_ - 1);
-	vi = ui(r_);
+RandomSinglePair::RandomSinglePair(int numVars, int seed)
+	: numVars_(numVars), r_(seed), next_(RING_SIZE) {
+	assert(numVars >= 2);
+}
 
-	if(config_) {
-		std::uniform_int_distribution<int> uj(0, config_->adjMatrix[vi].size() - 1);
-		vj = config_->adjMatrix[vi][uj(r_)];
+RandomSinglePair::RandomSinglePair(const NetConfig *config, int seed)
+	: numVars_(config->numVars), r_(seed), next_(RING_SIZE) {
+	adjStart_.resize(numVars_ + 1);
+	adjStart_[0] = 0;
+
+	for(int i = 0; i < numVars_; i++) {
+		const vector<int> &neighbors = config->adjMatrix[i];
+		adj_.insert(adj_.end(), neighbors.begin(), neighbors.end());
+		adjStart_[i+1] = adj_.size();
+	}
+}
+
+void RandomSinglePair::refill() {
+	if(!adjStart_.empty()) {
+		for(int k = 0; k < RING_SIZE; k++) {
+			int vi, degree;
+
+			do {
+				vi = r_.bounded(numVars_);
+				degree = adjStart_[vi+1] - adjStart_[vi];
+			} while(degree == 0);
+
+			ring_i_[k] = vi;
+			ring_j_[k] = adj_[adjStart_[vi] + r_.bounded(degree)];
+		}
 	} else { //Asssume clique
-		std::uniform_int_distribution<int> uj(0, numVars_ - 2);
-		vj = uj(r_);		
-		if(vj >= vi) {++vj;}
+		for(int k = 0; k < RING_SIZE; k++) {
+			int vi = r_.bounded(numVars_);
+			int vj = r_.bounded(numVars_ - 1);
+			ring_i_[k] = vi;
+			ring_j_[k] = vj + (vj >= vi);
+		}
 	}
+
+	next_ = 0;
 }
 
-void RandomKPairs::getPairs(int out_i[], int out_j[], int &n) {
-	n = numPairs;
+void ActiveSetPairs::getPairs(int out_i[], int out_j[], int &n) {
+	int size = activeSet_->size();
+	assert(size >= 2);
 
-	int numNeighbors[numVars];
-	for(int i = 0; i < numVars; i++) {numNeighbors[i] = adj[i].size();}
+	int ki = r_.bounded(size);
+	int kj = r_.bounded(size - 1);
+	if(kj >= ki) {++kj;}
 
-	int idx[numVars]; //mapping from pool index to node id
-	int backIdx[numVars]; //mapping from node id to pool index
-	for(int k = 0; k < numVars; k++) {backIdx[k] = idx[k] = k;}
+	out_i[0] = (*activeSet_)[ki];
+	out_j[0] = (*activeSet_)[kj];
+	n = 1;
+}
 
-	for(int k = 0; k < numPairs; k++) {
-		int idx_i = -1, vi = -1;
-		int lastIdx = numVars - 1 - 2*k;
+std::shared_ptr<const AliasTable> WeightedPairs::createTable(const vector<double> &weights,
+		const NetConfig *config) {
+	std::shared_ptr<AliasTable> table(new AliasTable(weights));
 
-		//Select vi
-		do {
-			std::uniform_int_distribution<int> ui(0, lastIdx);
-			idx_i = ui(r);
-			vi = idx[idx_i];
-		}while(numNeighbors[vi] == 0);
-
-		//Select vj from neighbors
-		std::uniform_int_distribution<int> uj(0, numNeighbors[vi] - 1);
-		int vj = adj[vi][uj(r)];
-		int idx_j = backIdx[vj];
-
-		//Remove vi from other nodes
-		for(int h = 0; h < numNeighbors[vi]; h++) {
-			int v = adj[vi][h];
-			auto pos = find(adj[v].begin(), adj[v].begin() + numNeighbors[v], vi);
-			int tmp = *pos;
-			*pos = adj[v][numNeighbors[v] - 1];
-			adj[v][numNeighbors[v] - 1] = tmp;
-			--numNeighbors[v];
+	if(config) {
+		assert(config->numVars == (int) weights.size());
+		vector<double> neighborWeights;
+
+		for(int i = 0; i < config->numVars; i++) {
+			const vector<int> &adj = config->adjMatrix[i];
+			neighborWeights.resize(std::max<size_t>(adj.size(), 1));
+			neighborWeights[0] = 1.0;	//Placeholder for isolated nodes
+			for(size_t k = 0; k < adj.size(); k++) {neighborWeights[k] = weights[adj[k]];}
+			table->add(neighborWeights.data(), neighborWeights.size());
 		}
+	}
 
-		//Remove vj from other nodes
-		for(int h = 0; h < numNeighbors[vj]; h++) {
-			int v = adj[vj][h];
-			auto pos = find(adj[v].begin(), adj[v].begin() + numNeighbors[v], vj);
-			int tmp = *pos;
-			*pos = adj[v][numNeighbors[v] - 1];
-			adj[v][numNeighbors[v] - 1] = tmp;
-			--numNeighbors[v];
+	return table;
+}
+
+void WeightedPairs::getPairs(int out_i[], int out_j[], int &n) {
+	int vi, vj;
+
+	if(config_) {
+		do {
+			vi = table_->sample(r_);
+		} while(config_->adjMatrix[vi].empty());
+
+		vj = config_->adjMatrix[vi][table_->sample(r_, vi + 1)];
+	} else {
+		int numVars = table_->size();
+		assert(numVars >= 2);
+		vi = table_->sample(r_);
+
+		//Rejection is cheap unless a single node dominates the weights,
+		//so fall back to a uniform choice after a few attempts.
+		int attempts = 0;
+		do {
+			vj = table_->sample(r_);
+		} while(vj == vi && ++attempts < 16);
+
+		if(vj == vi) {
+			vj = r_.bounded(numVars - 1);
+			if(vj >= vi) {++vj;}
 		}
+	}
+
+	out_i[0] = vi;
+	out_j[0] = vj;
+	n = 1;
+}
+
+const char PAIRS_MAGIC[8] = {'R', 'C', 'D', 'P', 'A', 'I', 'R', 0};
+const unsigned int PAIRS_VERSION = 2;
+const unsigned int PAIRS_BYTE_ORDER = 0x01020304;
 
-		//Output vi & vj
-		out_i[k] = vi;
-		out_j[k] = vj;
+struct PairTraceHeader {
+	char magic[8];
+	unsigned int version;
+	unsigned int byteOrder;
+	long long numRecords;
+	int bufSize;
+	int hasCounts;
+	int numVars;
+	char reserved[28];
+};
 
-		//Remove vi and vj from pool
-		assert(idx_i <= lastIdx);
-		if(backIdx[vi] != idx_i) {std::cerr << backIdx[vi] << "!=" << idx_i << std::endl;}
-		assert(backIdx[vi] == idx_i);
-		assert(backIdx[vj] <= lastIdx);
+static_assert(sizeof(PairTraceHeader) == 64, "Pair trace header must be 64 bytes");
 
-		idx[idx_i] = idx[lastIdx];
-		backIdx[idx[idx_i]] = idx_i;
-		idx_j = backIdx[idx[idx_j]];	//handle the case where idx_j = lastIdx
-		idx[idx_j] = idx[lastIdx-1];
-		backIdx[idx[idx_j]] = idx_j;
+static inline size_t align8(size_t n) {return (n + 7) & ~static_cast<size_t>(7);}
+
+static void writePadded(ofstream &out, const void *data, size_t bytes) {
+	static const char zeros[8] = {0};
+	out.write(static_cast<const char *>(data), bytes);
+	out.write(zeros, align8(bytes) - bytes);
+}
+
+void OfflinePairs::init(PairSelection *base, int numRecords, int numVars) {
+	assert(numRecords > 0 && numVars > 0);
+	storage_.reset();
+
+	numRecords_ = numRecords;
+	bufSize_ = base->getBufferSize();
+	numVars_ = numVars;
+	currentRecord_ = 0;
+
+	size_t numSlots = static_cast<size_t>(numRecords) * bufSize_;
+	numPairsStorage_.assign(numRecords, 0);
+	pairStorage_i_.assign(numSlots, 0);
+	pairStorage_j_.assign(numSlots, 0);
+
+	bool full = true;
+	for(int k = 0; k < numRecords; k++) {
+		size_t offset = static_cast<size_t>(k) * bufSize_;
+		base->getPairs(&pairStorage_i_[offset], &pairStorage_j_[offset], numPairsStorage_[k]);
+		assert(numPairsStorage_[k] >= 0 && numPairsStorage_[k] <= bufSize_);
+		full = full && (numPairsStorage_[k] == bufSize_);
+	}
+
+	if(full) {
+		numPairsStorage_.clear();
+		numPairsStorage_.shrink_to_fit();
 	}
+
+	numPairs_ = full ? 0 : numPairsStorage_.data();
+	pair_i_ = pairStorage_i_.data();
+	pair_j_ = pairStorage_j_.data();
 }
 
-void CoveringPairs::getPairs(int out_i[], int out_j[], int &n) {
-	n = 0;
-
-	bool selected[numVars];
-	std::fill(selected, selected + numVars, false);
-	int numNeighbors[numVars];
-	for(int i = 0; i < numVars; i++) {numNeighbors[i] = adj[i].size();}
-
-	for(int i = 0; i < numVars; i++) {
-		int vi = (startingPoint + i) % numVars;
-		if(selected[vi]) {continue;}
-
-		if(numNeighbors[vi] == 0) {continue;}
-
-		std::uniform_int_distribution<int> uj(0, numNeighbors[vi] - 1);
-		int vj = adj[vi][uj(r)];
-		assert(!selected[vj]);
-	
-		//Output vi & vj
-		out_i[n] = vi;
-		out_j[n++] = vj;
-		selected[vi] = selected[vj] = true;
-
-		//Remove vi from other nodes
-		for(int h = 0; h < numNeighbors[vi]; h++) {
-			int v = adj[vi][h];
-			auto pos = find(adj[v].begin(), adj[v].begin() + numNeighbors[v], vi);
-			int tmp = *pos;
-			*pos = adj[v][numNeighbors[v] - 1];
-			adj[v][numNeighbors[v] - 1] = tmp;
-			--numNeighbors[v];
+void OfflinePairs::save(const char *fileName) const {
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if(!out) {throw FileFormatException(string("Cannot create ") + fileName);}
+
+	PairTraceHeader header;
+	std::fill(reinterpret_cast<char *>(&header), reinterpret_cast<char *>(&header + 1), 0);
+	std::copy(PAIRS_MAGIC, PAIRS_MAGIC + 8, header.magic);
+	header.version = PAIRS_VERSION;
+	header.byteOrder = PAIRS_BYTE_ORDER;
+	header.numRecords = numRecords_;
+	header.bufSize = bufSize_;
+	header.hasCounts = (numPairs_ != 0);
+	header.numVars = numVars_;
+
+	size_t numSlots = static_cast<size_t>(numRecords_) * bufSize_;
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	if(numPairs_) {writePadded(out, numPairs_, numRecords_ * sizeof(int));}
+	writePadded(out, pair_i_, numSlots * sizeof(int));
+	writePadded(out, pair_j_, numSlots * sizeof(int));
+
+	if(!out) {throw FileFormatException(string("Failed writing ") + fileName);}
+}
+
+void OfflinePairs::load(const char *fileName, int numVars) {
+	std::shared_ptr<const MappedFile> file(new MappedFile(fileName));
+
+	if(file->size() < sizeof(PairTraceHeader)) {
+		throw FileFormatException(string("Truncated pair trace ") + fileName);
+	}
+
+	const PairTraceHeader *header = reinterpret_cast<const PairTraceHeader *>(file->data());
+
+	if(!std::equal(PAIRS_MAGIC, PAIRS_MAGIC + 8, header->magic)
+	   || header->version != PAIRS_VERSION || header->byteOrder != PAIRS_BYTE_ORDER
+	   || header->numRecords <= 0 || header->numRecords > INT_MAX || header->bufSize <= 0
+	   || (header->hasCounts != 0 && header->hasCounts != 1)) {
+		throw FileFormatException(string("Not a compatible pair trace ") + fileName);
+	}
+
+	if(header->numVars != numVars) {
+		throw FileFormatException(string("Pair trace ") + fileName + " was written for "
+				+ std::to_string(header->numVars) + " variables, expected " + std::to_string(numVars));
+	}
+
+	//Both factors are below 2^31, so numSlots cannot overflow. Bounding it by
+	//the file size first keeps the offsets below from overflowing as well.
+	int numRecords = static_cast<int>(header->numRecords);
+	int bufSize = header->bufSize;
+	size_t numSlots = static_cast<size_t>(numRecords) * bufSize;
+
+	if(numSlots > file->size() / (2 * sizeof(int))) {
+		throw FileFormatException(string("Truncated pair trace ") + fileName);
+	}
+
+	size_t countsOffset = sizeof(PairTraceHeader);
+	size_t iOffset = countsOffset + (header->hasCounts ? align8(numRecords * sizeof(int)) : 0);
+	size_t jOffset = iOffset + align8(numSlots * sizeof(int));
+	size_t end = jOffset + align8(numSlots * sizeof(int));
+
+	if(file->size() < end) {
+		throw FileFormatException(string("Truncated pair trace ") + fileName);
+	}
+
+	const int *counts = header->hasCounts ? reinterpret_cast<const int *>(file->data() + countsOffset) : 0;
+	const int *pair_i = reinterpret_cast<const int *>(file->data() + iOffset);
+	const int *pair_j = reinterpret_cast<const int *>(file->data() + jOffset);
+
+	//getPairs copies records into buffers of getBufferSize() pairs, and the
+	//scheduler indexes its variables with them unchecked
+	for(int k = 0; k < numRecords; k++) {
+		int n = counts ? counts[k] : bufSize;
+		if(n < 0 || n > bufSize) {
+			throw FileFormatException(string("Invalid record size in pair trace ") + fileName);
 		}
 
-		//Remove vj from other nodes
-		for(int h = 0; h < numNeighbors[vj]; h++) {
-			int v = adj[vj][h];
-			auto pos = find(adj[v].begin(), adj[v].begin() + numNeighbors[v], vj);
-			int tmp = *pos;
-			*pos = adj[v][numNeighbors[v] - 1];
-			adj[v][numNeighbors[v] - 1] = tmp;
-			--numNeighbors[v];
+		size_t offset = static_cast<size_t>(k) * bufSize;
+		for(int m = 0; m < n; m++) {
+			int vi = pair_i[offset + m];
+			int vj = pair_j[offset + m];
+			if(vi < 0 || vi >= numVars || vj < 0 || vj >= numVars) {
+				throw FileFormatException(string("Variable out of range in pair trace ") + fileName);
+			}
 		}
 	}
-	
-	startingPoint = (startingPoint + 1) % numVars;
-}
 
-void OfflinePairs::init(PairSelection *base, int numRecords) {
-	//cerr << "Creating offline samples" << endl;
-	cleanup();
+	numPairsStorage_.clear(); numPairsStorage_.shrink_to_fit();
+	pairStorage_i_.clear(); pairStorage_i_.shrink_to_fit();
+	pairStorage_j_.clear(); pairStorage_j_.shrink_to_fit();
 
-	currentRecord = 0;
-	this->numRecords = numRecords;
-	bufSize = base->getBufferSize();
+	storage_ = file;
+	numRecords_ = numRecords;
+	bufSize_ = bufSize;
+	numVars_ = numVars;
+	currentRecord_ = 0;
+	numPairs_ = counts;
+	pair_i_ = pair_i;
+	pair_j_ = pair_j;
+}
 
-	numPairs = new int[numRecords];
-	pair_i = new int*[numRecords];
-	pair_j = new int*[numRecords];
+size_t OfflinePairs::memoryBytes() const {
+	size_t numSlots = static_cast<size_t>(numRecords_) * bufSize_;
+	return (numPairs_ ? numRecords_ * sizeof(int) : 0) + 2 * numSlots * sizeof(int);
+}
 
-	for(int i = 0; i < numRecords; i++) {
-		pair_i[i] = new int[bufSize];
-		pair_j[i] = new int[bufSize];
-		base->getPairs(pair_i[i], pair_j[i], numPairs[i]);
+StreamingPairs::StreamingPairs(PairSelection *base, int capacity)
+	: base_(base), bufSize_(base->getBufferSize()), capacity_(capacity)
+	, numPairs_(capacity), pair_i_(static_cast<size_t>(capacity) * bufSize_)
+	, pair_j_(static_cast<size_t>(capacity) * bufSize_), wakePeriod_(std::max(capacity / 2, 1))
+	, head_(0), cachedTail_(0), tail_(0), stop_(false), producerWaiting_(false) {
+	assert(capacity > 0);
+	producer_ = std::thread(&StreamingPairs::produce, this);
+}
 
-		//if(i % 100 == 0) {
-		//	cerr << "Finished " << i << " samples" << endl;
-		//}
+StreamingPairs::~StreamingPairs() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_.store(true);
 	}
+
+	notFull_.notify_one();
+	producer_.join();
 }
 
-void OfflinePairs::getPairs(int out_i[], int out_j[], int &n) {
-	n = numPairs[currentRecord];
-	std::copy(pair_i[currentRecord], pair_i[currentRecord] + numPairs[currentRecord], out_i);
-	std::copy(pair_j[currentRecord], pair_j[currentRecord] + numPairs[currentRecord], out_j);
-	currentRecord = (currentRecord + 1) % numRecords;
+void StreamingPairs::getPairs(int out_i[], int out_j[], int &n) {
+	long long head = head_.load(std::memory_order_relaxed);
+
+	while(head == cachedTail_) {
+		cachedTail_ = tail_.load(std::memory_order_acquire);
+		if(head == cachedTail_) {std::this_thread::yield();}
+	}
+
+	int slot = head % capacity_;
+	size_t offset = static_cast<size_t>(slot) * bufSize_;
+	n = numPairs_[slot];
+	std::copy(&pair_i_[offset], &pair_i_[offset] + n, out_i);
+	std::copy(&pair_j_[offset], &pair_j_[offset] + n, out_j);
+
+	head_.store(head + 1, std::memory_order_release);
+
+	//A producer that found the ring full sleeps until it has drained by
+	//wakePeriod_ records. Pairs with the fence in produce(), so that either
+	//the producer sees the new head or we see its flag.
+	if((head + 1) % wakePeriod_ == 0) {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(producerWaiting_.load(std::memory_order_relaxed)) {
+			{std::lock_guard<std::mutex> lock(mutex_);}
+			notFull_.notify_one();
+		}
+	}
 }
 
-void OfflinePairs::cleanup() {
-	if(numPairs) {
-		for(int i = 0 ; i < numRecords; i++) {
-			delete pair_i[i];
-			delete pair_j[i];
+void StreamingPairs::produce() {
+	long long tail = 0;
+	long long cachedHead = 0;
+
+	while(!stop_.load(std::memory_order_relaxed)) {
+		if(tail - cachedHead == capacity_) {
+			cachedHead = head_.load(std::memory_order_acquire);
+
+			if(tail - cachedHead == capacity_) {
+				std::unique_lock<std::mutex> lock(mutex_);
+				producerWaiting_.store(true, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				//The consumer is at least one wake-up point away, since it
+				//has a full ring to work through
+				notFull_.wait(lock, [&] {
+					cachedHead = head_.load(std::memory_order_acquire);
+					return tail - cachedHead < capacity_ || stop_.load(std::memory_order_relaxed);
+				});
+
+				producerWaiting_.store(false, std::memory_order_relaxed);
+				continue;
+			}
 		}
 
-		delete pair_i;
-		delete pair_j;
-		delete numPairs;
+		int slot = tail % capacity_;
+		size_t offset = static_cast<size_t>(slot) * bufSize_;
+		base_->getPairs(&pair_i_[offset], &pair_j_[offset], numPairs_[slot]);
+		tail_.store(++tail, std::memory_order_release);
 	}
 }
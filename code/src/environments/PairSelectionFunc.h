@@ -4,6 +4,18 @@
 #include <vector>
 #include <random>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "core/ActiveSet.h"
+#include "core/FastRandom.h"
+#include "core/MappedFile.h"
+#include "core/Platform.h"
+#include "environments/AliasTable.h"
+#include "environments/MatchingSampler.h"
 #include "environments/NetConfig.h"
 
 class PairSelection {
@@ -13,86 +25,252 @@ public:
 	virtual void getPairs(int out_i[], int out_j[], int &n) = 0;
 };
 
+/**
+ * Selects i uniformly at random and j uniformly among the neighbours of i
+ * (or among all other variables if no NetConfig is given).
+ *
+ * This sits on the scheduler's hot path, so pairs are generated in bulk into a
+ * small ring buffer with a xoshiro generator, and the adjacency lists are
+ * copied once into a flat (CSR) array.
+ */
 class RandomSinglePair : public PairSelection {
 public:
-	RandomSinglePair(int numVars, int seed = 0)
-		: numVars_(numVars), config_(0), r_(seed) {}
+	RandomSinglePair(int numVars, int seed = 0);
+	RandomSinglePair(const NetConfig *config, int seed = 0);
+
+	void getPair(int &i, int &j) {
+		if(next_ == RING_SIZE) {refill();}
+		i = ring_i_[next_];
+		j = ring_j_[next_++];
+	}
 
-	RandomSinglePair(const NetConfig *config, int seed = 0)
-		: numVars_(config->numVars), config_(config), r_(seed) {}
-	void getPair(int &i, int &j);
 	virtual int getBufferSize() OVERRIDE {return 1;}
-	virtual void getPairs(int out_i[], int out_j[], int &n) {
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE {
 		getPair(out_i[0], out_j[0]);
 		n = 1;
 	}
 
 private:
+	static const int RING_SIZE = 256;
+
+	void refill();
+
 	int numVars_;
+	std::vector<int> adjStart_; //Neighbours of i are adj_[adjStart_[i]...adjStart_[i+1]-1]
+	std::vector<int> adj_;
+	Xoshiro256 r_;
+
+	int next_;
+	int ring_i_[RING_SIZE];
+	int ring_j_[RING_SIZE];
+};
+
+/**
+ * Selects a uniformly random pair of distinct variables among the variables
+ * that are currently active in an ActiveSet (i.e. not removed by shrinking).
+ * Assumes that all variables are connected (clique).
+ */
+class ActiveSetPairs : public PairSelection {
+public:
+	ActiveSetPairs(const ActiveSet *activeSet, int seed = 0)
+		: activeSet_(activeSet), r_(seed) {}
+
+	virtual int getBufferSize() OVERRIDE {return 1;}
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
+
+private:
+	const ActiveSet *activeSet_;
+	Xoshiro256 r_;
+};
+
+/**
+ * Importance sampling: selects i with probability proportional to a per-node
+ * weight (e.g. the Lipschitz constant L_i, or K_ii for SVMs) and j among the
+ * neighbours of i, again proportionally to their weights.
+ *
+ * The alias tables are built once by createTable and shared (read-only) by the
+ * selectors of all threads. Without a NetConfig all variables are assumed to
+ * be connected and j is drawn from the same table until it differs from i.
+ */
+class WeightedPairs : public PairSelection {
+public:
+	/**
+	Table holding the distribution over all nodes (index 0) followed by,
+	if a config is given, one distribution over the neighbours of each node.
+	*/
+	static std::shared_ptr<const AliasTable> createTable(const std::vector<double> &weights,
+			const NetConfig *config = 0);
+
+	WeightedPairs(std::shared_ptr<const AliasTable> table, const NetConfig *config = 0, int seed = 0)
+		: table_(table), config_(config), r_(seed) {}
+
+	virtual int getBufferSize() OVERRIDE {return 1;}
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
+
+private:
+	std::shared_ptr<const AliasTable> table_;
 	const NetConfig *config_;
-	std::default_random_engine r_;
+	Xoshiro256 r_;
 };
 
+/**
+ * Selects numPairs disjoint pairs per call (a random matching).
+ */
 class RandomKPairs : public PairSelection {
 public:
 	RandomKPairs(const NetConfig *config, int numPairs, int seed = 0)
-		: numVars(config->numVars), numPairs(numPairs), r(seed) {
-		adj = config->adjMatrix;
-	}
+		: numPairs(numPairs), sampler(config), r(seed) {}
 
 	virtual int getBufferSize() OVERRIDE {return numPairs;}
-	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE {
+		n = sampler.sampleRandom(numPairs, r, out_i, out_j);
+	}
 
 private:
-	int numVars;
 	int numPairs;
-	std::default_random_engine r;
-	std::vector<std::vector<int> > adj;
+	MatchingSampler sampler;
+	Xoshiro256 r;
 };
 
+/**
+ * Selects a maximal matching per call, scanning the variables from a starting
+ * point that advances by one on every call.
+ */
 class CoveringPairs : public PairSelection {
 public:
 	CoveringPairs(const NetConfig *config, int seed = 0)
-		: numVars(config->numVars), r(seed), startingPoint(0) {
-		adj = config->adjMatrix;
-	}
+		: numVars(config->numVars), sampler(config), r(seed), startingPoint(0) {}
 
 	virtual int getBufferSize() OVERRIDE {return numVars / 2;}
-	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE {
+		n = sampler.sampleCovering(startingPoint, r, out_i, out_j);
+		startingPoint = (startingPoint + 1) % numVars;
+	}
 
 private:
 	int numVars;
-	std::default_random_engine r;
+	MatchingSampler sampler;
+	Xoshiro256 r;
 	int startingPoint;
-
-	std::vector<std::vector<int> > adj;
 };
 
+/**
+ * Replays a fixed trace of records drawn beforehand from another selector,
+ * cycling through it. Record k holds up to getBufferSize() pairs.
+ *
+ * The trace is stored in flat arrays (record k at offset k * getBufferSize()),
+ * either owned or memory-mapped from a file written by save(), so that
+ * experiments can reuse identical pair sequences without regenerating them.
+ */
 class OfflinePairs : public PairSelection {
 public:
 	OfflinePairs()
-		: numPairs(0), pair_i(0), pair_j(0), bufSize(-1) {}
+		: numRecords_(0), bufSize_(-1), numVars_(0), currentRecord_(0)
+		, numPairs_(0), pair_i_(0), pair_j_(0) {}
 
-	~OfflinePairs() {cleanup();}
+	/**
+	Draws numRecords records from base, whose pairs index numVars variables.
+	*/
+	void init(PairSelection *base, int numRecords, int numVars);
 
-	void init(PairSelection *base, int numRecords);
-	virtual int getBufferSize() OVERRIDE {return bufSize;}
+	/**
+	Writes the trace to a binary file.
+	*/
+	void save(const char *fileName) const;
+
+	/**
+	Replaces the trace with a read-only mapping of a file written by save().
+	Throws FileFormatException if the file is missing or malformed, or was
+	written for a different number of variables.
+	*/
+	void load(const char *fileName, int numVars);
+
+	virtual int getBufferSize() OVERRIDE {return bufSize_;}
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE {
+		long long offset = static_cast<long long>(currentRecord_) * bufSize_;
+		n = numPairs_ ? numPairs_[currentRecord_] : bufSize_;
+		std::copy(pair_i_ + offset, pair_i_ + offset + n, out_i);
+		std::copy(pair_j_ + offset, pair_j_ + offset + n, out_j);
+		if(++currentRecord_ == numRecords_) {currentRecord_ = 0;}
+	}
+
+	int getNumRecords() const {return numRecords_;}
+	int getNumVars() const {return numVars_;}
+	bool isMapped() const {return static_cast<bool>(storage_);}
+	size_t memoryBytes() const;
+
+private:
+	OfflinePairs(const OfflinePairs &);
+	OfflinePairs &operator=(const OfflinePairs &);
+
+	int numRecords_;
+	int bufSize_;
+	int numVars_;
+	int currentRecord_;
+
+	const int *numPairs_; //Null when every record holds bufSize_ pairs
+	const int *pair_i_;
+	const int *pair_j_;
+
+	std::vector<int> numPairsStorage_;
+	std::vector<int> pairStorage_i_;
+	std::vector<int> pairStorage_j_;
+	std::shared_ptr<const MappedFile> storage_;
+};
+
+/**
+ * Draws records from a base selector on a background thread and hands them
+ * to the caller through a lock-free single-producer/single-consumer ring,
+ * so the trace never has to be materialized. The base selector must not
+ * depend on solver state (e.g. ActiveSetPairs), since it runs ahead of it.
+ *
+ * When the ring is full the producer sleeps on a condition variable. The
+ * consumer only checks for a sleeping producer every wakePeriod_ records, so
+ * getPairs stays free of locks otherwise.
+ */
+class StreamingPairs : public PairSelection {
+public:
+	/**
+	Takes ownership of base. capacity is the number of records in the ring.
+	*/
+	StreamingPairs(PairSelection *base, int capacity = 4096);
+	~StreamingPairs();
+
+	virtual int getBufferSize() OVERRIDE {return bufSize_;}
 	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
-	int getNumRecords() const {return numRecords;}
 
 private:
-	OfflinePairs(const OfflinePairs &) {}
-	OfflinePairs &operator=(const OfflinePairs &) {return *this;}
+	StreamingPairs(const StreamingPairs &);
+	StreamingPairs &operator=(const StreamingPairs &);
+
+	void produce();
+
+	std::unique_ptr<PairSelection> base_;
+	int bufSize_;
+	int capacity_;
+	std::vector<int> numPairs_;
+	std::vector<int> pair_i_;
+	std::vector<int> pair_j_;
+	int wakePeriod_;
+
+	//Explicit padding keeps both sides on separate cache lines without
+	//requiring an over-aligned allocation of the object
+	char padding0_[Platform::CACHE_LINE_SIZE];
 
-	void cleanup();
+	//Consumer side
+	std::atomic<long long> head_;
+	long long cachedTail_;
+	char padding1_[Platform::CACHE_LINE_SIZE];
 
-	int currentRecord;
-	int numRecords;
+	//Producer side
+	std::atomic<long long> tail_;
+	std::atomic<bool> stop_;
+	std::atomic<bool> producerWaiting_;
+	char padding2_[Platform::CACHE_LINE_SIZE];
 
-	int *numPairs;
-	int **pair_i;
-	int **pair_j;
-	int bufSize;
+	std::mutex mutex_;
+	std::condition_variable notFull_;
+	std::thread producer_;
 };
 
 #endif
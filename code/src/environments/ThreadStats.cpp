@@ -0,0 +1,73 @@
+#include <string>
+#include "environments/ThreadStats.h"
+
+const char *ThreadStats::phaseName(int phase) {
+	static const char *names[NUM_PHASES] = {"lock", "read", "master", "slave", "update"};
+	return names[phase];
+}
+
+void ThreadStats::reset() {
+	numUpdates = 0;
+	numCollisions = 0;
+	numAscents = 0;
+	numLockSpins = 0;
+	numRetries = 0;
+	readTime = 0.0;
+	masterTime = 0.0;
+	slaveTime = 0.0;
+	updateTime = 0.0;
+
+#ifdef USE_PHASE_HISTOGRAMS
+	for(int p = 0; p < NUM_PHASES; ++p) {phaseHist[p].reset();}
+#endif
+}
+
+void ThreadStats::add(const ThreadStats &other) {
+	numUpdates += other.numUpdates;
+	numCollisions += other.numCollisions;
+	numAscents += other.numAscents;
+	numLockSpins += other.numLockSpins;
+	numRetries += other.numRetries;
+	readTime += other.readTime;
+	masterTime += other.masterTime;
+	slaveTime += other.slaveTime;
+	updateTime += other.updateTime;
+
+#ifdef USE_PHASE_HISTOGRAMS
+	for(int p = 0; p < NUM_PHASES; ++p) {phaseHist[p].add(other.phaseHist[p]);}
+#endif
+}
+
+ThreadStats ThreadStats::merge(const PaddedArray<ThreadStats> &stats) {
+	ThreadStats total;
+	for(size_t t = 0; t < stats.size(); ++t) {total.add(stats[t]);}
+	return total;
+}
+
+void ThreadStats::report(OptOutput &output, bool timings) const {
+	//Counters easily pass 2^31 on long runs, so they are not narrowed to int
+	output.propDouble["collisions"] = static_cast<double>(numCollisions);
+	output.propDouble["ascents"] = static_cast<double>(numAscents);
+	output.propDouble["lock_spins"] = static_cast<double>(numLockSpins);
+	output.propDouble["optimistic_retries"] = static_cast<double>(numRetries);
+
+	if(timings) {
+		//Summed over threads
+		output.propDouble["time_read"] = readTime;
+		output.propDouble["time_master"] = masterTime;
+		output.propDouble["time_slave"] = slaveTime;
+		output.propDouble["time_update"] = updateTime;
+	}
+
+#ifdef USE_PHASE_HISTOGRAMS
+	for(int p = 0; p < NUM_PHASES; ++p) {
+		const LatencyHistogram &h = phaseHist[p];
+		if(h.count() == 0) {continue;}
+
+		std::string name = phaseName(p);
+		output.propDouble[name + "_p50_ns"] = h.quantile(0.5);
+		output.propDouble[name + "_p99_ns"] = h.quantile(0.99);
+		output.propDouble[name + "_max_ns"] = h.max();
+	}
+#endif
+}
@@ -0,0 +1,133 @@
+#ifndef _RCD_THREADSTATS_H_
+#define _RCD_THREADSTATS_H_
+
+#include <chrono>
+#include "core/LatencyHistogram.h"
+#include "core/PaddedArray.h"
+#include "core/RCDScheduler.h"
+
+/**
+ * Counters kept by a single worker thread of a scheduler.
+ * Each thread owns one instance in a PaddedArray and is its only writer,
+ * so counting does not need synchronization and does not move cache lines
+ * between cores. The instances are merged once the solver finishes.
+ *
+ * When built with USE_PHASE_HISTOGRAMS (make USEHIST=1, which builds into
+ * bin/<config>-hist) every thread also keeps a latency histogram per phase
+ * of a pair update, filled through PhaseHistogramTimer. Otherwise the
+ * histograms do not exist and the timer compiles to nothing.
+ */
+struct ThreadStats {
+	enum Phase {
+		PHASE_LOCK = 0, //Waiting for locks
+		PHASE_READ, //ParameterReadClient::getNodeInput
+		PHASE_MASTER, //getInfoAsMaster and updateAsMaster
+		PHASE_SLAVE, //updateAsSlave
+		PHASE_UPDATE, //ParameterUpdateClient::update
+		NUM_PHASES
+	};
+
+	static const char *phaseName(int phase);
+
+	long long numUpdates;
+	long long numCollisions;
+	long long numAscents;
+	long long numLockSpins; //Failed attempts made while waiting for locks
+	long long numRetries; //Optimistic updates discarded because a variable changed
+
+	//Seconds spent in each phase of a pair update. Only collected when timings are enabled.
+	double readTime;
+	double masterTime;
+	double slaveTime;
+	double updateTime;
+
+#ifdef USE_PHASE_HISTOGRAMS
+	LatencyHistogram phaseHist[NUM_PHASES];
+#endif
+
+	ThreadStats() {reset();}
+
+	void reset();
+	void add(const ThreadStats &other);
+
+	void addLockSpins(int spins) {numLockSpins += spins;}
+
+	/**
+	Sums the stats of all threads.
+	*/
+	static ThreadStats merge(const PaddedArray<ThreadStats> &stats);
+
+	/**
+	Stores the counters (and timings, if collected) in output.propInt and output.propDouble.
+	With phase histograms, also stores <phase>_p50_ns, <phase>_p99_ns and
+	<phase>_max_ns for every phase that was recorded.
+	*/
+	void report(OptOutput &output, bool timings) const;
+};
+
+/**
+ * Measures the time elapsed between consecutive calls to lap().
+ * When disabled the clock is never read and lap() returns 0.
+ */
+class PhaseTimer {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	PhaseTimer(bool enabled)
+		: enabled_(enabled) {
+		if(enabled_) {last_ = Clock::now();}
+	}
+
+	double lap() {
+		if(!enabled_) {return 0.0;}
+
+		Clock::time_point now = Clock::now();
+		double elapsed = std::chrono::duration<double>(now - last_).count();
+		last_ = now;
+		return elapsed;
+	}
+
+private:
+	bool enabled_;
+	Clock::time_point last_;
+};
+
+/**
+ * Records the time elapsed between consecutive calls to lap() in the given
+ * phase histogram of a thread. Without USE_PHASE_HISTOGRAMS it is empty and
+ * never reads the clock.
+ */
+#ifdef USE_PHASE_HISTOGRAMS
+class PhaseHistogramTimer {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	PhaseHistogramTimer(ThreadStats &stats)
+		: stats_(stats), last_(Clock::now()) {}
+
+	void lap(ThreadStats::Phase phase) {
+		Clock::time_point now = Clock::now();
+		stats_.phaseHist[phase].record(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+		last_ = now;
+	}
+
+	/**
+	Starts the next interval without recording the current one.
+	*/
+	void skip() {last_ = Clock::now();}
+
+private:
+	ThreadStats &stats_;
+	Clock::time_point last_;
+};
+#else
+class PhaseHistogramTimer {
+public:
+	PhaseHistogramTimer(ThreadStats &) {}
+	void lap(ThreadStats::Phase) {}
+	void skip() {}
+};
+#endif
+
+#endif
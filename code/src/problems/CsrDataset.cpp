@@ -0,0 +1,94 @@
+#include "problems/CsrDataset.h"
+
+CsrDataset &CsrDataset::operator=(const CsrDataset &other) {
+	rowPtrStorage_ = other.rowPtrStorage_;
+	indexStorage_ = other.indexStorage_;
+	valueStorage_ = other.valueStorage_;
+	storage_ = other.storage_;
+	numFeatures_ = other.numFeatures_;
+
+	if(storage_) {
+		rowPtr_ = other.rowPtr_;
+		indices_ = other.indices_;
+		values_ = other.values_;
+		numRows_ = other.numRows_;
+	} else {
+		syncPointers();
+	}
+
+	return *this;
+}
+
+void CsrDataset::reserve(int numRows, long long nnz) {
+	rowPtrStorage_.reserve(numRows + 1);
+	indexStorage_.reserve(nnz);
+	valueStorage_.reserve(nnz);
+	syncPointers();
+}
+
+void CsrDataset::addRow(const int *indices, const double *values, int nnz) {
+	ASSERT(!storage_, "Cannot add rows to an attached dataset");
+
+	for(int k = 0; k < nnz; ++k) {
+		ASSERT(k == 0 || indices[k-1] < indices[k], "Row indices must be sorted. row=" << size());
+		ASSERT(indices[k] >= 0, "Negative feature index. row=" << size());
+	}
+
+	indexStorage_.insert(indexStorage_.end(), indices, indices + nnz);
+	valueStorage_.insert(valueStorage_.end(), values, values + nnz);
+	rowPtrStorage_.push_back(rowPtrStorage_.back() + nnz);
+	syncPointers();
+
+	if(nnz > 0 && indices[nnz-1] >= numFeatures_) {numFeatures_ = indices[nnz-1] + 1;}
+}
+
+void CsrDataset::assign(std::vector<long long> &&rowPtr, std::vector<int> &&indices,
+		std::vector<double> &&values, int numFeatures) {
+	ASSERT(!rowPtr.empty() && rowPtr[0] == 0, "Invalid row pointers");
+	ASSERT(rowPtr.back() == static_cast<long long>(indices.size())
+		   && indices.size() == values.size(), "Inconsistent CSR arrays");
+
+	storage_.reset();
+	rowPtrStorage_.swap(rowPtr);
+	indexStorage_.swap(indices);
+	valueStorage_.swap(values);
+	numFeatures_ = numFeatures;
+	syncPointers();
+}
+
+void CsrDataset::setNumFeatures(int numFeatures) {
+	ASSERT(numFeatures >= numFeatures_, numFeatures << " < " << numFeatures_);
+	numFeatures_ = numFeatures;
+}
+
+void CsrDataset::attach(std::shared_ptr<const MappedFile> storage, int numRows, int numFeatures,
+		const long long *rowPtr, const int *indices, const double *values) {
+	rowPtrStorage_.clear(); rowPtrStorage_.shrink_to_fit();
+	indexStorage_.clear(); indexStorage_.shrink_to_fit();
+	valueStorage_.clear(); valueStorage_.shrink_to_fit();
+
+	storage_ = storage;
+	numRows_ = numRows;
+	numFeatures_ = numFeatures;
+	rowPtr_ = rowPtr;
+	indices_ = indices;
+	values_ = values;
+}
+
+size_t CsrDataset::memoryBytes() const {
+	if(storage_) {
+		return (numRows_ + 1) * sizeof(long long)
+			+ nonZeros() * (sizeof(int) + sizeof(double));
+	}
+
+	return rowPtrStorage_.capacity() * sizeof(long long)
+		+ indexStorage_.capacity() * sizeof(int)
+		+ valueStorage_.capacity() * sizeof(double);
+}
+
+void CsrDataset::syncPointers() {
+	rowPtr_ = rowPtrStorage_.data();
+	indices_ = indexStorage_.data();
+	values_ = valueStorage_.data();
+	numRows_ = rowPtrStorage_.size() - 1;
+}
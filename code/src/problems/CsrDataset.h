@@ -0,0 +1,143 @@
+#ifndef _RCD_CSRDATASET_H_
+#define _RCD_CSRDATASET_H_
+
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+#include "core/MappedFile.h"
+
+/**
+ * Sparse dataset in compressed sparse row (CSR) format.
+ * The nonzeros of all examples are stored in a single index array and a single
+ * value array. Example i occupies entries [rowPtr[i], rowPtr[i+1]) of both arrays.
+ * Indices within an example are sorted in increasing order.
+ *
+ * The arrays are either owned by the dataset (when built with addRow) or
+ * point into a memory-mapped file (see attach), in which case the dataset
+ * is read-only.
+ */
+class CsrDataset {
+public:
+	/**
+	 * Read-only view of a single example. Cheap to copy; remains valid as long as
+	 * no rows are added to the dataset.
+	 */
+	struct Row {
+		const int *indices;
+		const double *values;
+		int nnz;
+
+		int nonZeros() const {return nnz;}
+
+		double dot(const Eigen::VectorXd &w) const {
+			const double *wRaw = w.data();
+			double sum = 0.0;
+
+			for(int k = 0; k < nnz; ++k) {
+				sum += wRaw[indices[k]] * values[k];
+			}
+
+			return sum;
+		}
+
+		double dot(const Row &other) const {
+			double sum = 0.0;
+			int k1 = 0, k2 = 0;
+
+			while(k1 < nnz && k2 < other.nnz) {
+				int idx1 = indices[k1];
+				int idx2 = other.indices[k2];
+
+				if(idx1 == idx2) {sum += values[k1++] * other.values[k2++];}
+				else if(idx1 < idx2) {++k1;}
+				else {++k2;}
+			}
+
+			return sum;
+		}
+	};
+
+	typedef Row value_type;
+
+	CsrDataset()
+		: numFeatures_(0) {
+		rowPtrStorage_.push_back(0);
+		syncPointers();
+	}
+
+	CsrDataset(const CsrDataset &other) {*this = other;}
+	CsrDataset &operator=(const CsrDataset &other);
+
+	int size() const {return numRows_;}
+	int numFeatures() const {return numFeatures_;}
+	long long nonZeros() const {return rowPtr_[numRows_];}
+
+	Row operator[](int i) const {
+		Row row;
+		long long start = rowPtr_[i];
+		row.indices = indices_ + start;
+		row.values = values_ + start;
+		row.nnz = static_cast<int>(rowPtr_[i+1] - start);
+		return row;
+	}
+
+	const long long *rowPtrData() const {return rowPtr_;}
+	const int *indexData() const {return indices_;}
+	const double *valueData() const {return values_;}
+
+	/**
+	Preallocates storage for the given number of examples and nonzeros.
+	*/
+	void reserve(int numRows, long long nnz);
+
+	/**
+	Appends an example. Indices must be sorted in increasing order.
+	*/
+	void addRow(const int *indices, const double *values, int nnz);
+
+	/**
+	Replaces the contents of the dataset with the given CSR arrays, taking
+	ownership of their storage. rowPtr must start with 0 and have one more
+	entry than the number of examples. Indices within each row must be sorted.
+	*/
+	void assign(std::vector<long long> &&rowPtr, std::vector<int> &&indices,
+			std::vector<double> &&values, int numFeatures);
+
+	/**
+	Sets the dimensionality of the data, which defaults to
+	the largest index seen so far plus one.
+	*/
+	void setNumFeatures(int numFeatures);
+
+	/**
+	Makes the dataset a read-only view of externally stored CSR arrays.
+	The arrays must stay valid as long as "storage" is alive; the dataset
+	keeps a reference to it.
+	*/
+	void attach(std::shared_ptr<const MappedFile> storage, int numRows, int numFeatures,
+			const long long *rowPtr, const int *indices, const double *values);
+
+	bool isAttached() const {return static_cast<bool>(storage_);}
+
+	/**
+	Returns the number of bytes used to store the dataset.
+	For attached datasets this is the size of the mapped arrays.
+	*/
+	size_t memoryBytes() const;
+
+private:
+	void syncPointers();
+
+	const long long *rowPtr_;
+	const int *indices_;
+	const double *values_;
+	int numRows_;
+	int numFeatures_;
+
+	std::vector<long long> rowPtrStorage_;
+	std::vector<int> indexStorage_;
+	std::vector<double> valueStorage_;
+	std::shared_ptr<const MappedFile> storage_;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "problems/KernelCache.h"
+#include <algorithm>
+
+KernelCache::KernelCache(int numExamples, Kernel kernel, double budgetMB)
+	: numExamples_(numExamples), kernel_(kernel), budgetBytes_(0),
+	  entries_(new Entry[numExamples]), rowLocks_(std::max(1, std::min(numExamples, ROW_LOCK_STRIPES))), hand_(0),
+	  numHits_(Platform::getNumLocalThreads()), numMisses_(0), numEvictions_(0) {
+	setBudget(budgetMB);
+}
+
+KernelCache::Row KernelCache::getRow(int i) {
+	Entry &entry = entries_[i];
+
+	rowLock(i).lock();
+	Row row = entry.row;
+	rowLock(i).unlock();
+
+	if(row) {
+		//Avoid writing the shared line if the bit is already set
+		if(!entry.referenced.load(std::memory_order_relaxed)) {
+			entry.referenced.store(true, std::memory_order_relaxed);
+		}
+
+		++numHits_[Platform::getThreadId() % numHits_.size()];
+		return row;
+	}
+
+	std::shared_ptr<Eigen::VectorXd> newRow(new Eigen::VectorXd(numExamples_));
+	double *values = newRow->data();
+	for(int k = 0; k < numExamples_; ++k) {values[k] = kernel_(i, k);}
+	row = newRow;
+
+	lock_.lock();
+	++numMisses_;
+
+	//Rows are only inserted and evicted with lock_ held, so entry.row can be read here
+	if(entry.row) {
+		//Computed by another thread in the meantime
+		row = entry.row;
+	} else if(rowBytes() <= budgetBytes_) {
+		while(usedBytes() + rowBytes() > budgetBytes_) {evictOne();}
+
+		rowLock(i).lock();
+		entry.row = row;
+		rowLock(i).unlock();
+		entry.referenced.store(false, std::memory_order_relaxed);
+		clock_.push_back(i);
+	}
+
+	lock_.unlock();
+	return row;
+}
+
+void KernelCache::setBudget(double budgetMB) {
+	lock_.lock();
+	budgetBytes_ = static_cast<size_t>(budgetMB * 1024.0 * 1024.0);
+	while(usedBytes() > budgetBytes_) {evictOne();}
+	lock_.unlock();
+}
+
+long long KernelCache::getNumHits() const {
+	long long sum = 0;
+	for(size_t t = 0; t < numHits_.size(); ++t) {sum += numHits_[t];}
+	return sum;
+}
+
+void KernelCache::evictOne() {
+	//Referenced rows get a second chance; the sweep ends after one round at most
+	while(true) {
+		if(hand_ >= clock_.size()) {hand_ = 0;}
+		Entry &entry = entries_[clock_[hand_]];
+		if(!entry.referenced.exchange(false, std::memory_order_relaxed)) {break;}
+		++hand_;
+	}
+
+	int victim = clock_[hand_];
+	clock_[hand_] = clock_.back();
+	clock_.pop_back();
+
+	rowLock(victim).lock();
+	entries_[victim].row.reset();
+	rowLock(victim).unlock();
+	++numEvictions_;
+}
@@ -0,0 +1,84 @@
+#ifndef _RCD_KERNELCACHE_H_
+#define _RCD_KERNELCACHE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <Eigen/Core>
+#include "core/PaddedArray.h"
+#include "core/SpinLock.h"
+
+typedef std::function<double(int, int)> Kernel;
+
+/**
+ * Memory-bounded cache of kernel matrix rows, evicted in CLOCK (second chance)
+ * order. Row i holds K(i, k) for all examples k.
+ *
+ * Rows are handed out as shared pointers, so a row stays valid for the caller
+ * even if it is evicted concurrently. getRow may be called from multiple threads.
+ * A hit only takes the striped lock guarding the row's pointer and sets the
+ * row's reference bit, so threads hitting different rows do not contend.
+ * Misses take a lock shared by the whole cache to insert the row and sweep
+ * the clock for victims. The row is computed outside any lock; two threads
+ * missing the same row may both compute it, in which case one copy is kept.
+ */
+class KernelCache {
+public:
+	typedef std::shared_ptr<const Eigen::VectorXd> Row;
+
+	KernelCache(int numExamples, Kernel kernel, double budgetMB = 100.0);
+
+	Row getRow(int i);
+
+	/**
+	Sets the memory budget in megabytes, evicting rows if needed.
+	A budget smaller than a single row disables caching.
+	*/
+	void setBudget(double budgetMB);
+
+	int numExamples() const {return numExamples_;}
+	size_t rowBytes() const {return static_cast<size_t>(numExamples_) * sizeof(double);}
+	size_t usedBytes() const {return clock_.size() * rowBytes();}
+	int numCachedRows() const {return static_cast<int>(clock_.size());}
+
+	long long getNumHits() const;
+	long long getNumMisses() const {return numMisses_;}
+	long long getNumEvictions() const {return numEvictions_;}
+
+private:
+	struct Entry {
+		Entry() : referenced(false) {}
+
+		Row row; //Guarded by rowLock(i)
+		std::atomic<bool> referenced;
+	};
+
+	static const int ROW_LOCK_STRIPES = 1024;
+
+	KernelCache(const KernelCache &);
+	KernelCache &operator=(const KernelCache &);
+
+	SpinLock &rowLock(int i) {return rowLocks_[static_cast<size_t>(i) % rowLocks_.size()];}
+
+	//Must be called with lock_ held
+	void evictOne();
+
+	int numExamples_;
+	Kernel kernel_;
+	size_t budgetBytes_;
+
+	std::unique_ptr<Entry[]> entries_;
+	PaddedArray<SpinLock> rowLocks_;
+
+	//Guarded by lock_
+	std::vector<int> clock_; //Cached rows
+	size_t hand_;
+	SpinLock lock_;
+
+	PaddedArray<long long> numHits_; //Per thread
+	long long numMisses_;
+	long long numEvictions_;
+};
+
+#endif
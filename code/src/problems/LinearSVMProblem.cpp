@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include "LinearSVMProblem.h"
 #include "core/SpinLock.h"
@@ -17,9 +18,10 @@ public:
 		: problem_(problem) {}
 
 	virtual void getNodeInput(int varId, LinearSVMNodeInput &nodeInput) OVERRIDE {
-		nodeInput.alpha = &(problem_->x_[0]);
+		nodeInput.alpha = problem_->x_.data();
 		nodeInput.numVars = problem_->numVars_;
 		nodeInput.w = &(problem_->w_);
+		nodeInput.alphaSeq = problem_->alphaSeq_.get();
 	}
 
 	virtual LinearSVMStaticInput getNodeStaticInput(int varId) OVERRIDE {
@@ -45,11 +47,45 @@ public:
 	}
 
 	~LinearSVMLocalParameterUpdateClient() {
-		if(locks_) {delete locks_;}
+		if(locks_) {delete[] locks_;}
 	}
 
 	virtual void update(int varId1, int varId2, const Eigen::VectorXd& increment1,
 				const Eigen::VectorXd& increment2, bool async) OVERRIDE {
+		apply(varId1, varId2, increment1, increment2, async || problem_->atomicWeightUpdates_, true);
+	}
+
+	virtual void updateExclusive(int varId1, int varId2, const Eigen::VectorXd& increment1,
+				const Eigen::VectorXd& increment2, bool async) OVERRIDE {
+		apply(varId1, varId2, increment1, increment2, async || problem_->atomicWeightUpdates_, false);
+	}
+
+private:
+	/**
+	lockVars is false if the caller already owns the variables.
+	*/
+	void apply(int varId1, int varId2, const Eigen::VectorXd& increment1,
+			const Eigen::VectorXd& increment2, bool atomic, bool lockVars) {
+		//Single variable update (used when the scheduler locks one variable at a time)
+		if(varId1 < 0 || varId2 < 0) {
+			int id = (varId1 >= 0) ?varId1 :varId2;
+			const Eigen::VectorXd &increment = (varId1 >= 0) ?increment1 :increment2;
+
+			if(lockVars) {locks_[id].lock();}
+			double a = problem_->x_[id][0];
+			double anew = std::min(std::max(a + increment[0], 0.0), problem_->C_);
+			problem_->alphaSeq_->beginWrite(id);
+			problem_->x_[id][0] = anew;
+			problem_->alphaSeq_->endWrite(id);
+			if(lockVars) {locks_[id].unlock();}
+
+			problem_->recordActivity(id, anew == a && (anew == 0.0 || anew == problem_->C_));
+
+			addScaledRow(id, (anew - a) * problem_->y_[id], atomic);
+			countUpdate();
+			return;
+		}
+
 		//In SVM we need to need to scale updates to maintain box constraint
 		int id1 = varId1, id2 = varId2;
 		double delta1 = increment1[0];
@@ -62,8 +98,10 @@ public:
 			delta2 = increment1[0];
 		}
 
-		locks_[id1].lock();
-		locks_[id2].lock();
+		if(lockVars) {
+			locks_[id1].lock();
+			locks_[id2].lock();
+		}
 
 		double a1 = problem_->x_[id1][0];
 		double a2 = problem_->x_[id2][0];
@@ -91,19 +129,40 @@ public:
 
 		assert(scale >= 0.0);
 
-		problem_->x_[id1][0] = a1 + scale * delta1;
-		problem_->x_[id2][0] = a2 + scale * delta2;
+		a1new = a1 + scale * delta1;
+		a2new = a2 + scale * delta2;
+		SeqLockArray &seq = *problem_->alphaSeq_;
+		seq.beginWrite(id1); seq.beginWrite(id2);
+		problem_->x_[id1][0] = a1new;
+		problem_->x_[id2][0] = a2new;
+		seq.endWrite(id2); seq.endWrite(id1);
+
+		if(lockVars) {
+			locks_[id2].unlock();
+			locks_[id1].unlock();
+		}
 
-		locks_[id2].unlock();
-		locks_[id1].unlock();
+		problem_->recordActivity(id1, a1new == a1 && (a1new == 0.0 || a1new == C));
+		problem_->recordActivity(id2, a2new == a2 && (a2new == 0.0 || a2new == C));
 
-		Data wdiff = scale * delta1 * problem_->y_[id1] * (*problem_->data_)[id1]
-			+ scale * delta2 * problem_->y_[id2] * (*problem_->data_)[id2];
+		//Stream both rows into w without building their weighted sum
+		addScaledRow(id1, scale * delta1 * problem_->y_[id1], atomic);
+		addScaledRow(id2, scale * delta2 * problem_->y_[id2], atomic);
+		countUpdate();
+	}
 
-		Platform::updateVector(problem_->w_, wdiff, true); //TODO: Make atomic adds configurable
+	void countUpdate() {
+		SVMViolationIndex *index = problem_->violationIndex_.get();
+		if(index) {index->countUpdate([this] () {problem_->rebuildViolationIndex(false);});}
+	}
+
+	void addScaledRow(int id, double scale, bool atomic) {
+		if(scale == 0.0) {return;}
+		Data row = (*problem_->data_)[id];
+		Platform::addScaledSparse(problem_->w_.data(), row.indices,
+				row.values, row.nnz, scale, atomic);
 	}
 
-private:
 	LinearSVMProblem *problem_;
 	SpinLock *locks_;
 };
@@ -120,7 +179,7 @@ void LinearSVMNode::init(int phase, const LinearSVMNode::NodeStaticInput &static
 	y_ = staticInput.y;
 	data_ = staticInput.data;
 
-	const auto &data_i = (*data_)[varId_];
+	Data data_i = (*data_)[varId_];
 	kSelf_ = data_i.dot(data_i);
 	assert(kSelf_ >= 0);
 }
@@ -142,15 +201,20 @@ void LinearSVMNode::updateAsSlave(int masterId, const LinearSVMNode::MasterInfo
 	const LinearSVMNode::NodeInput &input, LinearSVMNode::SlaveInfo& slaveInfo,
 	LinearSVMNode::Update& slaveUpdate) const {
 	int i = masterId; int j = varId_;
-	double alphai = input.alpha[i][0];
-	double alphaj = input.alpha[j][0];
+	double alphai, alphaj;
+	if(input.alphaSeq) {
+		input.alphaSeq->readPair(input.alpha, i, j, alphai, alphaj);
+	} else {
+		alphai = input.alpha[i];
+		alphaj = input.alpha[j];
+	}
 
 	double R = 0.0;
 	double Kii = masterInfo.kSelf;
 	double Kjj = kSelf_;
 
-	const auto &data_i = (*data_)[i];
-	const auto &data_j = (*data_)[j];
+	Data data_i = (*data_)[i];
+	Data data_j = (*data_)[j];
 
 	double Kij = data_i.dot(data_j);
 	double yi = y_[i];
@@ -159,8 +223,8 @@ void LinearSVMNode::updateAsSlave(int masterId, const LinearSVMNode::MasterInfo
 
 	double S = alphai * yi + alphaj * yj;
 
-	Eigen::VectorXd ddiff = data_i - data_j;
-	R = input.w->dot(ddiff);
+	//w'(x_i - x_j) computed from the sparse rows, O(nnz_i + nnz_j)
+	R = data_i.dot(*input.w) - data_j.dot(*input.w);
 	R = R - alphai * yi * Kii + alphai * yi * Kij - alphaj * yj * Kij + alphaj * yj * Kjj;
 	R = yi * R;
 
@@ -211,14 +275,42 @@ ParameterUpdateClient *LinearSVMProblem::createLocalParameterUpdateClient() {
 	return new LinearSVMLocalParameterUpdateClient(this);
 }
 
+void LinearSVMProblem::beginBlock() {
+	Super::beginBlock();
+	if(violationIndex_) {rebuildViolationIndex();}
+}
+
+void LinearSVMProblem::rebuildViolationIndex(bool full) {
+	violationIndex_->rebuild(numVars_, activeSet_.get(), x_.data(), y_.data(), C_,
+			[this] (int t) -> double {return gradient(t);}, full);
+}
+
+void LinearSVMProblem::enableWorkingSetSelection(int numCandidates, int rebuildPeriod) {
+	violationIndex_.reset(new SVMViolationIndex(numCandidates, rebuildPeriod, numCandidates));
+	beginBlock();
+}
+
+void LinearSVMProblem::shrink() {
+	const double *alpha = x_.data();
+	SVMShrinkingRule rule(C_);
+
+	for(int k = 0; k < activeSet_->size(); ++k) {
+		int t = (*activeSet_)[k];
+		rule.add(alpha[t], y_[t], gradient(t));
+	}
+
+	activeSet_->compact([this, alpha, &rule] (int t) -> bool {
+		return rule.canShrink(alpha[t], y_[t], gradient(t));});
+}
+
 double LinearSVMProblem::computeObjective() const {
 	double sum = w_.dot(w_);
 
 	// for(int i = 0; i < numVars_; ++i) {
-	// 	const auto &data_i = (*data_)[i];
+	// 	Data data_i = (*data_)[i];
 
 	// 	for(int j = 0; j < numVars_; ++j) {
-	// 		const auto &data_j = (*data_)[j];
+	// 		Data data_j = (*data_)[j];
 	// 		sum += data_i.dot(data_j) * y_[i] * y_[j]
 	// 			* x_[i][0] * x_[j][0];
 	// 	}
@@ -226,8 +318,10 @@ double LinearSVMProblem::computeObjective() const {
 
 	sum /= 2.0;
 
+	const double *alpha = x_.data();
+
 	for(int i = 0; i < numVars_; ++i) {
-		sum -= x_[i][0];
+		sum -= alpha[i];
 	}
 
 	return sum;
@@ -252,11 +346,11 @@ void LinearSVMProblem::computeSVsAndIntercept() {
 
 	for(int i = 0; i < n; i++) {
 		double score = 0.0;
-		const auto &data_i = (*data_)[supportVectors_[i].index];
+		Data data_i = (*data_)[supportVectors_[i].index];
 
 		for(int j = 0; j < n; j++) {
 				
-			const auto &data_j = (*data_)[supportVectors_[j].index];
+			Data data_j = (*data_)[supportVectors_[j].index];
 
 
 			score += supportVectors_[j].weight
@@ -2,15 +2,17 @@
 #define _RCD_LINEARSVMPROBLEM_H_
 
 #include "SVMProblem.h"
+#include "problems/CsrDataset.h"
 
-typedef Eigen::SparseVector<double> Data;
-typedef std::vector<Data> Dataset;
+typedef CsrDataset Dataset;
+typedef CsrDataset::Row Data;
 
 struct LinearSVMNodeInput {
 	int numVars;
-	const Eigen::VectorXd *alpha;
+	const double *alpha; //alpha[k] is the value of the k-th variable
 	const Eigen::VectorXd *w;
 	const Dataset *dataset;
+	const SeqLockArray *alphaSeq; //Guards writes to alpha
 };
 
 struct LinearSVMStaticInput {
@@ -63,7 +65,8 @@ public:
 	};
 
  LinearSVMProblem(const Dataset *data, int numFeatures, double C) :
-			Super(data->size(), 1), data_(data), C_(C), b_(0) {
+			Super(data->size(), 1), data_(data), C_(C), b_(0),
+			atomicWeightUpdates_(true), alphaSeq_(new SeqLockArray(data->size())) {
 				w_ = Eigen::VectorXd::Zero(numFeatures);
 				y_.resize(data->size());
 	}
@@ -75,6 +78,13 @@ public:
 	double alpha(int i) const {return x_[i][0];}
 	double b() const {return b_;}
 
+	// Controls whether w is updated with atomic adds when the scheduler
+	// does not request asynchronous updates (e.g. DOUBLE locking).
+	// Locking a pair of examples does not protect w, since different
+	// pairs can share features, so plain adds are only safe when pair
+	// updates never overlap (e.g. a single thread).
+	void setAtomicWeightUpdates(bool atomic) {atomicWeightUpdates_ = atomic;}
+
 	virtual ParameterReadClient<LinearSVMNodeInput, LinearSVMStaticInput>
 	*createLocalParameterReadClient() override;
 
@@ -88,12 +98,41 @@ public:
 
 	void computeSVsAndIntercept();
 
+	virtual void beginBlock() override;
+
+	/**
+	Maximal KKT violation at the last rebuild of the violation index, -1 without one.
+	*/
+	virtual double optimalityGap() const override {return violationIndex_ ?violationIndex_->gap() :-1.0;}
+
+	/**
+	Dual gradient y_t w'x_t - 1, O(nnz) of example t.
+	*/
+	double gradient(int t) const {return y_[t] * (*data_)[t].dot(w_) - 1.0;}
+
+	/**
+	 * Maintains an SVMViolationIndex over the numCandidates most violating
+	 * variables for use by MaxViolatingPairs, rebuilt as for SVMProblem.
+	 * Since a gradient costs O(nnz) of its example, only the rebuild before a
+	 * block passes over all data. Rebuilds during a block rescan the
+	 * candidates and a slice of numCandidates further examples.
+	 * Labels must be set before calling this.
+	 */
+	void enableWorkingSetSelection(int numCandidates, int rebuildPeriod = 0);
+	const SVMViolationIndex *violationIndex() const {return violationIndex_.get();}
+
 protected:
+	virtual void shrink() override;
+	void rebuildViolationIndex(bool full = true);
+
 	const Dataset *data_;
 	Eigen::VectorXd w_;
 	std::vector<double> y_;
 	double C_;
 	double b_;
+	bool atomicWeightUpdates_;
+	std::shared_ptr<SeqLockArray> alphaSeq_;
+	std::shared_ptr<SVMViolationIndex> violationIndex_;
 
 	std::vector<SV> supportVectors_;
 };
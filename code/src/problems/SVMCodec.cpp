@@ -14,7 +14,7 @@ void SVMCodec::encodeNodeInput(const SVMNodeInput& input, std::string &codedInpu
 	proto.mutable_alpha()->mutable_elements()->Reserve(size);
 
 	for(int i = 0; i < size; ++i) {
-		proto.mutable_alpha()->mutable_elements()->Add(input.alpha[i][0]);
+		proto.mutable_alpha()->mutable_elements()->Add(input.alpha[i]);
 	}
 
 	codedInput = proto.SerializeAsString();
@@ -25,14 +25,15 @@ void SVMCodec::decodeNodeInput(const std::string &codedInput, SVMNodeInput &inpu
 	SVMInputProto proto;
 	proto.ParseFromString(codedInput);
 	int size = proto.numvars();
-	Eigen::VectorXd *alpha = new Eigen::VectorXd[size];
+	double *alpha = new double[size];
 
 	for(int i = 0; i < size; ++i) {
-		alpha[i].resize(1);
-		alpha[i][0] = proto.alpha().elements(i);
+		alpha[i] = proto.alpha().elements(i);
 	}
 
 	input.alpha = alpha;
+	input.F = 0; //F is not transmitted; nodes sum over alpha instead
+	input.alphaSeq = 0;
 }
 
 void SVMCodec::encodeNodeStaticInput(const SVMStaticInput& input, std::string &codedInput) {
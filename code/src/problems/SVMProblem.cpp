@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include "SVMProblem.h"
 #include "core/SpinLock.h"
@@ -16,7 +17,9 @@ public:
 		: problem_(problem) {}
 
 	virtual void getNodeInput(int varId, SVMNodeInput &nodeInput) OVERRIDE {
-		nodeInput.alpha = &(problem_->x_[0]);
+		nodeInput.alpha = problem_->x_.data();
+		nodeInput.F = problem_->incrementalF_ ?problem_->F_.data() :0;
+		nodeInput.alphaSeq = problem_->alphaSeq_.get();
 		nodeInput.numVars = problem_->numVars_;
 	}
 
@@ -41,11 +44,50 @@ public:
 	}
 
 	~SVMLocalParameterUpdateClient() {
-		if(locks_) {delete locks_;}
+		if(locks_) {delete[] locks_;}
+	}
+
+	virtual void init(int varId) OVERRIDE {
+		Super::init(varId);
+		problem_->F_[varId] = 0.0;
 	}
 
 	virtual void update(int varId1, int varId2, const Eigen::VectorXd& increment1,
 				const Eigen::VectorXd& increment2, bool async) OVERRIDE {
+		apply(varId1, varId2, increment1, increment2, async || problem_->atomicFUpdates_, true);
+	}
+
+	virtual void updateExclusive(int varId1, int varId2, const Eigen::VectorXd& increment1,
+				const Eigen::VectorXd& increment2, bool async) OVERRIDE {
+		apply(varId1, varId2, increment1, increment2, async || problem_->atomicFUpdates_, false);
+	}
+
+private:
+	/**
+	lockVars is false if the caller already owns the variables.
+	*/
+	void apply(int varId1, int varId2, const Eigen::VectorXd& increment1,
+			const Eigen::VectorXd& increment2, bool atomic, bool lockVars) {
+		//Single variable update (used when the scheduler locks one variable at a time)
+		if(varId1 < 0 || varId2 < 0) {
+			int id = (varId1 >= 0) ?varId1 :varId2;
+			const Eigen::VectorXd &increment = (varId1 >= 0) ?increment1 :increment2;
+
+			if(lockVars) {locks_[id].lock();}
+			double a = problem_->x_[id][0];
+			double anew = std::min(std::max(a + increment[0], 0.0), problem_->C_);
+			problem_->alphaSeq_->beginWrite(id);
+			problem_->x_[id][0] = anew;
+			problem_->alphaSeq_->endWrite(id);
+			if(lockVars) {locks_[id].unlock();}
+
+			problem_->recordActivity(id, anew == a && (anew == 0.0 || anew == problem_->C_));
+
+			updateF(id, anew - a, -1, 0.0, atomic);
+			countUpdate();
+			return;
+		}
+
 		//In SVM we need to need to scale updates to maintain box constraint
 		int id1 = varId1, id2 = varId2;
 		double delta1 = increment1[0];
@@ -58,8 +100,10 @@ public:
 			delta2 = increment1[0];
 		}
 
-		locks_[id1].lock();
-		locks_[id2].lock();
+		if(lockVars) {
+			locks_[id1].lock();
+			locks_[id2].lock();
+		}
 
 		double a1 = problem_->x_[id1][0];
 		double a2 = problem_->x_[id2][0];
@@ -87,14 +131,86 @@ public:
 
 		assert(scale >= 0.0);
 
-		problem_->x_[id1][0] = a1 + scale * delta1;
-		problem_->x_[id2][0] = a2 + scale * delta2;
+		a1new = a1 + scale * delta1;
+		a2new = a2 + scale * delta2;
+		SeqLockArray &seq = *problem_->alphaSeq_;
+		seq.beginWrite(id1); seq.beginWrite(id2);
+		problem_->x_[id1][0] = a1new;
+		problem_->x_[id2][0] = a2new;
+		seq.endWrite(id2); seq.endWrite(id1);
+
+		if(lockVars) {
+			locks_[id2].unlock();
+			locks_[id1].unlock();
+		}
 
-		locks_[id2].unlock();
-		locks_[id1].unlock();
+		problem_->recordActivity(id1, a1new == a1 && (a1new == 0.0 || a1new == C));
+		problem_->recordActivity(id2, a2new == a2 && (a2new == 0.0 || a2new == C));
+
+		updateF(id1, scale * delta1, id2, scale * delta2, atomic);
+		countUpdate();
+	}
+
+	void countUpdate() {
+		SVMViolationIndex *index = problem_->violationIndex_.get();
+		if(index) {index->countUpdate([this] () {problem_->rebuildViolationIndex(false);});}
+	}
+
+	/**
+	Adds d1 y[id1] K(:, id1) + d2 y[id2] K(:, id2) to F. id2 may be -1.
+	*/
+	void updateF(int id1, double d1, int id2, double d2, bool atomic) {
+		if(!problem_->incrementalF_) {return;}
+		if(d2 == 0.0) {id2 = -1;}
+		if(d1 == 0.0) {id1 = id2; d1 = d2; id2 = -1;}
+		if(id1 < 0) {return;}
+
+		int n = problem_->numVars_;
+		double *F = problem_->F_.data();
+		double c1 = d1 * problem_->y_[id1];
+		KernelCache::Row row1 = problem_->cache_->getRow(id1);
+		const double *K1 = row1->data();
+		KernelCache::Row row2;
+		const double *K2 = 0;
+		if(id2 >= 0) {
+			row2 = problem_->cache_->getRow(id2);
+			K2 = row2->data();
+		}
+
+		if(problem_->incrementalObjective_) {
+			//Change of 1/2 a'Qa - sum(a), where (Qa)_k = y_k F_k, evaluated before F is updated.
+			//F is read without synchronization, so concurrent updates of other pairs may be
+			//missing from it; the error is removed when refreshState recomputes F.
+			double delta = d1 * (problem_->y_[id1] * F[id1] - 1.0) + 0.5 * d1 * d1 * K1[id1];
+
+			if(id2 >= 0) {
+				double y2 = problem_->y_[id2];
+				delta += d2 * (y2 * F[id2] - 1.0) + 0.5 * d2 * d2 * K2[id2]
+						+ d1 * d2 * problem_->y_[id1] * y2 * K1[id2];
+			}
+
+			PaddedArray<double> &parts = problem_->objectiveParts_;
+			Platform::atomicAdd(&parts[Platform::getThreadId() % parts.size()], delta);
+		}
+
+		if(id2 < 0) {
+			for(int k = 0; k < n; ++k) {
+				if(atomic) {Platform::atomicAdd(F + k, c1 * K1[k]);}
+				else {F[k] += c1 * K1[k];}
+			}
+
+			return;
+		}
+
+		double c2 = d2 * problem_->y_[id2];
+
+		if(atomic) {
+			for(int k = 0; k < n; ++k) {Platform::atomicAdd(F + k, c1 * K1[k] + c2 * K2[k]);}
+		} else {
+			for(int k = 0; k < n; ++k) {F[k] += c1 * K1[k] + c2 * K2[k];}
+		}
 	}
 
-private:
 	SVMProblem *problem_;
 	SpinLock *locks_;
 };
@@ -129,22 +245,48 @@ void SVMNode::updateAsSlave(int masterId, const SVMNode::MasterInfo &masterInfo,
 	const SVMNode::NodeInput &input, SVMNode::SlaveInfo& slaveInfo,
 	SVMNode::Update& slaveUpdate) const {
 	int i = masterId; int j = varId_;
-	double alphai = input.alpha[i][0];
-	double alphaj = input.alpha[j][0];
+	double alphai, alphaj;
+	if(input.alphaSeq) {
+		input.alphaSeq->readPair(input.alpha, i, j, alphai, alphaj);
+	} else {
+		alphai = input.alpha[i];
+		alphaj = input.alpha[j];
+	}
 
 	double R = 0.0;
 	double Kii = masterInfo.kSelf;
 	double Kjj = kSelf_;
-	double Kij = kernel_(masterId, varId_);
+	double Kij;
 	double yi = y_[i];
 	double yj = y_[j];
 	double yij = yi * yj;
 
 	double S = alphai * yi + alphaj * yj;
 
-	for(int k = 0; k < numVars_; ++k) {
-		if(k != i && k != j && input.alpha[k][0] > 0.0) {
-			R += input.alpha[k][0] * y_[k] * yi * (kernel_(k,i) - kernel_(k,j));
+	if(input.F) {
+		//Remove the contributions of i and j from the maintained F values
+		Kij = kernel_(i, j);
+		R = yi * (input.F[i] - input.F[j]
+				- alphai * yi * (Kii - Kij) - alphaj * yj * (Kij - Kjj));
+	} else if(cache_) {
+		KernelCache::Row rowI = cache_->getRow(i);
+		KernelCache::Row rowJ = cache_->getRow(j);
+		const double *Ki = rowI->data();
+		const double *Kj = rowJ->data();
+		Kij = Ki[j];
+
+		for(int k = 0; k < numVars_; ++k) {
+			if(k != i && k != j && input.alpha[k] > 0.0) {
+				R += input.alpha[k] * y_[k] * yi * (Ki[k] - Kj[k]);
+			}
+		}
+	} else {
+		Kij = kernel_(masterId, varId_);
+
+		for(int k = 0; k < numVars_; ++k) {
+			if(k != i && k != j && input.alpha[k] > 0.0) {
+				R += input.alpha[k] * y_[k] * yi * (kernel_(k,i) - kernel_(k,j));
+			}
 		}
 	}
 
@@ -196,24 +338,121 @@ ParameterUpdateClient *SVMProblem::createLocalParameterUpdateClient() {
 }
 
 double SVMProblem::computeObjective() const {
+	if(incrementalF_ && incrementalObjective_) {
+		double sum = 0.0;
+		for(size_t t = 0; t < objectiveParts_.size(); ++t) {sum += objectiveParts_[t];}
+		return sum;
+	}
+
+	return computeExactObjective();
+}
+
+double SVMProblem::computeExactObjective() const {
+	const double *alpha = x_.data();
 	double sum = 0.0;
 
+	#pragma omp parallel for schedule(dynamic, 16) reduction(+:sum)
 	for(int i = 0; i < numVars_; ++i) {
+		if(alpha[i] == 0.0) {continue;}
+
 		for(int j = 0; j < numVars_; ++j) {
 			sum += kernel_(i,j) * y_[i] * y_[j]
-				* x_[i][0] * x_[j][0];
+				* alpha[i] * alpha[j];
 		}
 	}
 
 	sum /= 2.0;
 
 	for(int i = 0; i < numVars_; ++i) {
-		sum -= x_[i][0];
+		sum -= alpha[i];
 	}
 
 	return sum;
 }
 
+void SVMProblem::recomputeF(int begin, int end) {
+	const double *alpha = x_.data();
+	std::fill(F_.begin() + begin, F_.begin() + end, 0.0);
+
+	for(int m = 0; m < numVars_; ++m) {
+		if(alpha[m] == 0.0) {continue;}
+
+		double c = alpha[m] * y_[m];
+		KernelCache::Row row = cache_->getRow(m);
+		const double *K = row->data();
+
+		for(int k = begin; k < end; ++k) {F_[k] += c * K[k];}
+	}
+}
+
+void SVMProblem::refreshState(int block, int threadId, int numThreads) {
+	if(!incrementalF_ || refreshPeriod_ <= 0 || (block + 1) % refreshPeriod_ != 0) {return;}
+
+	long long begin = static_cast<long long>(numVars_) * threadId / numThreads;
+	long long end = static_cast<long long>(numVars_) * (threadId + 1) / numThreads;
+	recomputeF(begin, end);
+
+	if(incrementalObjective_) {
+		//The objective is 1/2 sum_k alpha_k y_k F_k - sum_k alpha_k
+		const double *alpha = x_.data();
+		double part = 0.0;
+		for(long long k = begin; k < end; ++k) {part += alpha[k] * (0.5 * y_[k] * F_[k] - 1.0);}
+
+		int numParts = objectiveParts_.size();
+		ASSERT(numThreads <= numParts, "More refreshing threads than objective parts");
+		objectiveParts_[threadId] = part;
+
+		if(threadId == 0) {
+			for(int t = numThreads; t < numParts; ++t) {objectiveParts_[t] = 0.0;}
+		}
+	}
+}
+
+void SVMProblem::beginBlock() {
+	Super::beginBlock();
+	if(violationIndex_) {rebuildViolationIndex();}
+}
+
+void SVMProblem::rebuildViolationIndex(bool full) {
+	violationIndex_->rebuild(numVars_, activeSet_.get(), x_.data(), y_.data(), C_,
+			[this] (int t) -> double {return gradient(t);}, full);
+}
+
+double SVMProblem::gradient(int t) const {
+	if(incrementalF_) {return y_[t] * F_[t] - 1.0;}
+
+	const double *alpha = x_.data();
+	double f = 0.0;
+	for(int m = 0; m < numVars_; ++m) {
+		if(alpha[m] != 0.0) {f += alpha[m] * y_[m] * kernel_(t, m);}
+	}
+
+	return y_[t] * f - 1.0;
+}
+
+void SVMProblem::enableWorkingSetSelection(int numCandidates, int rebuildPeriod) {
+	violationIndex_.reset(new SVMViolationIndex(numCandidates, rebuildPeriod));
+	beginBlock();
+}
+
+void SVMProblem::shrink() {
+	if(!incrementalF_) {
+		Super::shrink();
+		return;
+	}
+
+	const double *alpha = x_.data();
+	SVMShrinkingRule rule(C_);
+
+	for(int k = 0; k < activeSet_->size(); ++k) {
+		int t = (*activeSet_)[k];
+		rule.add(alpha[t], y_[t], gradient(t));
+	}
+
+	activeSet_->compact([this, alpha, &rule] (int t) -> bool {
+		return rule.canShrink(alpha[t], y_[t], gradient(t));});
+}
+
 void SVMProblem::computeSVsAndIntercept() {
 	supportVectors_.clear();
 
@@ -231,13 +470,16 @@ void SVMProblem::computeSVsAndIntercept() {
 	double minScore = INFINITY;
 	double maxScore = -INFINITY;
 
+	//Only the SV-SV entries of the kernel are needed, so they are computed
+	//directly instead of fetching (and caching) a full row per SV
+	#pragma omp parallel for schedule(dynamic, 16) reduction(min:minScore) reduction(max:maxScore)
 	for(int i = 0; i < n; i++) {
 		double score = 0.0;
+		int si = supportVectors_[i].index;
 
 		for(int j = 0; j < n; j++) {
-			score += supportVectors_[j].weight
-					* kernel_(supportVectors_[i].index, supportVectors_[j].index)
-					* y_[supportVectors_[j].index];
+			int sj = supportVectors_[j].index;
+			score += supportVectors_[j].weight * kernel_(si, sj) * y_[sj];
 		}
 
 		if(score < minScore) {minScore = score;}
@@ -1,9 +1,16 @@
 #ifndef _RCD_SVMPROBLEM_H_
 #define _RCD_SVMPROBLEM_H_
 
+#include <cmath>
+#include <memory>
 #include <Eigen/SparseCore>
+#include "core/PaddedArray.h"
 #include "core/Problem.h"
 #include "core/RCDNode.h"
+#include "core/SeqLock.h"
+#include "problems/CsrDataset.h"
+#include "problems/KernelCache.h"
+#include "problems/SVMWorkingSet.h"
 
 struct SVMMasterInfo {
 	double kSelf;
@@ -21,7 +28,9 @@ struct SVMStaticInput {
 
 struct SVMNodeInput {
 	int numVars;
-	const Eigen::VectorXd *alpha;
+	const double *alpha; //alpha[k] is the value of the k-th variable
+	const double *F; //F[k] = sum_m alpha[m] y[m] K(k, m), or null if not maintained
+	const SeqLockArray *alphaSeq; //Guards writes to alpha, or null if alpha is not shared
 };
 
 struct SVMInfoSpec {
@@ -31,12 +40,10 @@ struct SVMInfoSpec {
 	typedef SVMStaticInput NodeStaticInput;
 };
 
-typedef std::function<double(int, int)> Kernel;
-
-template<class Data = Eigen::SparseVector<double> >
+template<class Dataset = CsrDataset>
 class KernelOnDataset {
 public:
-	typedef std::vector<Data> Dataset;
+	typedef typename Dataset::value_type Data;
 
 	KernelOnDataset(const Dataset &data)
 		: data_(data) {}
@@ -49,15 +56,15 @@ protected:
 	virtual double kernelFunc(const Data &x1, const Data &x2) const = 0;
 
 private:
-	const std::vector<Data> &data_;
+	const Dataset &data_;
 };
 
-template<class Data = Eigen::SparseVector<double> >
-class LinearKernel : public KernelOnDataset<Data> {
-	typedef typename KernelOnDataset<Data>::Dataset Dataset;
+template<class Dataset = CsrDataset>
+class LinearKernel : public KernelOnDataset<Dataset> {
+	typedef typename KernelOnDataset<Dataset>::Data Data;
 public:
 	LinearKernel(const Dataset &data)
-		: KernelOnDataset<>(data) {}
+		: KernelOnDataset<Dataset>(data) {}
 
 protected:
 	virtual double kernelFunc(const Data &x1, const Data &x2) const override {
@@ -65,11 +72,48 @@ protected:
 	}
 };
 
+/**
+ * LIBSVM's shrinking test for the SVM dual, based on the dual gradient
+ * G_t = y_t f_t - 1, where f_t = sum_m alpha_m y_m K(t, m).
+ * After adding all active variables, canShrink tells whether a variable at a
+ * bound violates optimality less than every pair it could form.
+ */
+class SVMShrinkingRule {
+public:
+	SVMShrinkingRule(double C)
+		: C_(C), gMax1_(-INFINITY), gMax2_(-INFINITY) {}
+
+	void add(double alpha, double y, double G) {
+		if(y > 0) {
+			if(alpha < C_ && -G > gMax1_) {gMax1_ = -G;}
+			if(alpha > 0.0 && G > gMax2_) {gMax2_ = G;}
+		} else {
+			if(alpha < C_ && -G > gMax2_) {gMax2_ = -G;}
+			if(alpha > 0.0 && G > gMax1_) {gMax1_ = G;}
+		}
+	}
+
+	bool canShrink(double alpha, double y, double G) const {
+		if(alpha >= C_) {return (y > 0) ?(-G > gMax1_) :(-G > gMax2_);}
+		if(alpha <= 0.0) {return (y > 0) ?(G > gMax2_) :(G > gMax1_);}
+		return false;
+	}
+
+private:
+	double C_;
+	double gMax1_;
+	double gMax2_;
+};
+
 class SVMNode: public RCDNode<SVMInfoSpec> {
 	typedef RCDNode<SVMInfoSpec> Super;
 public:
-	SVMNode(int varId, Kernel kernel)
-		: Super(varId), kernel_(kernel) {}
+	/**
+	 * If a kernel cache is given, kernel values are read from cached rows.
+	 * Otherwise they are computed directly from the kernel function.
+	 */
+	SVMNode(int varId, Kernel kernel, KernelCache *cache = 0)
+		: Super(varId), kernel_(kernel), cache_(cache) {}
 
 	virtual void init(int phase, const NodeStaticInput &staticInput) override;
 
@@ -86,6 +130,7 @@ private:
 	int numVars_;
 	double C_;
 	Kernel kernel_;
+	KernelCache *cache_;
 	double kSelf_;
 	const double *y_;
 };
@@ -101,8 +146,13 @@ public:
 	};
 
 	SVMProblem(int numExamples, Kernel kernel, double C) :
-			Super(numExamples, 1), kernel_(kernel), C_(C), b_(0) {
+			Super(numExamples, 1), kernel_(kernel), C_(C), b_(0),
+			cache_(new KernelCache(numExamples, kernel)),
+			incrementalF_(true), atomicFUpdates_(Platform::getNumLocalThreads() > 1), refreshPeriod_(10),
+			incrementalObjective_(true), objectiveParts_(Platform::getNumLocalThreads()),
+			alphaSeq_(new SeqLockArray(numExamples)) {
 		y_.resize(numExamples);
+		F_.assign(numExamples, 0.0);
 	}
 
 	double &y(int i) {
@@ -112,6 +162,86 @@ public:
 	double alpha(int i) const {return x_[i][0];}
 	double b() const {return b_;}
 
+	/**
+	Sets the memory budget of the kernel row cache (100MB by default).
+	*/
+	void setKernelCacheSize(double megabytes) {cache_->setBudget(megabytes);}
+	const KernelCache &kernelCache() const {return *cache_;}
+
+	/**
+	 * Maintains F[k] = sum_m alpha_m y_m K(k, m) for all examples, updating it
+	 * from two kernel rows after each pair update. Nodes then compute a pair
+	 * update in O(1) instead of summing over all examples. Enabled by default;
+	 * must be set before solving.
+	 */
+	void setIncrementalGradient(bool incremental) {incrementalF_ = incremental;}
+
+	/**
+	 * Whether F is updated with atomic adds. Concurrent pair updates touch all
+	 * entries of F whatever the locking level, so plain adds lose updates as
+	 * soon as several threads run. Atomic adds are therefore the default if
+	 * more than one local thread is configured when the problem is created.
+	 * Plain adds are only safe with a single thread (or when updates are
+	 * otherwise serialized). Lock-free updates always use atomic adds.
+	 */
+	void setAtomicGradientUpdates(bool atomic) {atomicFUpdates_ = atomic;}
+
+	/**
+	 * F is recomputed from scratch every "blocks" convergence blocks to bound
+	 * the accumulated rounding error. Non-positive values disable the recompute.
+	 */
+	void setGradientRefreshPeriod(int blocks) {refreshPeriod_ = blocks;}
+
+	double F(int k) const {return F_[k];}
+
+	/**
+	 * Tracks the objective from the changes applied by each pair update, using
+	 * the F values and kernel entries the update already reads, so that
+	 * computeObjective costs O(threads). The tracked value is reset to the exact
+	 * objective whenever F is refreshed. Requires the incremental gradient;
+	 * enabled by default.
+	 *
+	 * With concurrent updates the F values read for a delta may miss updates
+	 * still in flight on other threads, so the tracked objective drifts from
+	 * the exact one until the next refresh, every setGradientRefreshPeriod
+	 * blocks.
+	 */
+	void setIncrementalObjective(bool incremental) {incrementalObjective_ = incremental;}
+
+	/**
+	Computes the objective from scratch in O(n^2) kernel evaluations.
+	*/
+	double computeExactObjective() const;
+
+	/**
+	Recomputes F from the current alpha for examples [begin, end).
+	*/
+	void recomputeF(int begin, int end);
+
+	virtual void refreshState(int block, int threadId, int numThreads) override;
+	virtual void beginBlock() override;
+
+	/**
+	Maximal KKT violation at the last rebuild of the violation index, -1 without one.
+	*/
+	virtual double optimalityGap() const override {return violationIndex_ ?violationIndex_->gap() :-1.0;}
+
+	/**
+	Dual gradient y_t F_t - 1. O(1) with the incremental gradient, O(n) kernel evaluations otherwise.
+	*/
+	double gradient(int t) const;
+
+	/**
+	 * Maintains an SVMViolationIndex over the numCandidates most violating
+	 * variables for use by MaxViolatingPairs. The index is rebuilt before
+	 * every block and, while threads update, by one thread at a time every
+	 * rebuildPeriod updates of that thread (see SVMViolationIndex). Its gap
+	 * then serves as the optimality gap. Labels must be set before calling this.
+	 */
+	void enableWorkingSetSelection(int numCandidates, int rebuildPeriod = 0);
+	const SVMViolationIndex *violationIndex() const {return violationIndex_.get();}
+	const Kernel &kernel() const {return kernel_;}
+
 	virtual ParameterReadClient<SVMNodeInput, SVMStaticInput>
 	*createLocalParameterReadClient() override;
 
@@ -120,17 +250,39 @@ public:
 
 	virtual double computeObjective() const override;
 	virtual RCDNode<SVMInfoSpec> *createNode(int varId) override {
-		return new SVMNode(varId, kernel_);
+		return new SVMNode(varId, kernel_, cache_.get());
 	}
 
 	void computeSVsAndIntercept();
 
+protected:
+	virtual void shrink() override;
+
 private:
+	void rebuildViolationIndex(bool full = true);
+
 	std::vector<double> y_;
 	Kernel kernel_;
 	double C_;
 	double b_;
+	std::unique_ptr<KernelCache> cache_;
+
+	std::vector<double> F_;
+	bool incrementalF_;
+	bool atomicFUpdates_;
+	int refreshPeriod_;
+
+	//The tracked objective is the sum of the parts. Each thread adds the changes
+	//it applies to its own part; a refresh sets part t to the exact objective
+	//restricted to the examples refreshed by thread t.
+	bool incrementalObjective_;
+	PaddedArray<double> objectiveParts_;
+
+	//Lets nodes read a consistent (alpha_i, alpha_j) pair while the update
+	//client writes alpha under its per-example locks
+	std::unique_ptr<SeqLockArray> alphaSeq_;
 
+	std::shared_ptr<SVMViolationIndex> violationIndex_;
 	std::vector<SV> supportVectors_;
 };
 
@@ -1,113 +1,408 @@
 #include "SVMUtils.h"
 #include <string>
 #include <fstream>
-#include <sstream>
 #include <cstdlib>
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include "core/MappedFile.h"
+#include "core/Platform.h"
 
 using namespace std;
 using namespace Eigen;
 
-void SVMUtils::readSvmFile(const char *fileName, std::vector<SparseVector<double> > &data, std::vector<double> &labels, int &numFeatures) {
-	ifstream in(fileName);
-	//TODO: Check file
+namespace {
 
-	string line, token;
-	int linenum = 0;
-	numFeatures = -1;
+const char CACHE_MAGIC[8] = {'R', 'C', 'D', 'C', 'S', 'R', 0, 0};
+const unsigned int CACHE_VERSION = 1;
+const unsigned int CACHE_BYTE_ORDER = 0x01020304;
+
+struct SvmCacheHeader {
+	char magic[8];
+	unsigned int version;
+	unsigned int byteOrder;
+	long long numRows;
+	long long numFeatures;
+	long long nnz;
+	long long reserved[3];
+};
+
+static_assert(sizeof(SvmCacheHeader) == 64, "Cache header must be 64 bytes");
+
+inline size_t align8(size_t n) {return (n + 7) & ~static_cast<size_t>(7);}
+
+void writePadded(ofstream &out, const void *data, size_t bytes) {
+	static const char zeros[8] = {0};
+	out.write(static_cast<const char *>(data), bytes);
+	out.write(zeros, align8(bytes) - bytes);
+}
+
+//Smallest amount of text worth handing to a separate thread
+const size_t MIN_CHUNK_BYTES = 1 << 16;
+
+inline bool isBlank(char c) {return c == ' ' || c == '\t' || c == '\r';}
+
+/**
+ * Text to be parsed by one thread: a range of whole lines. The last line of
+ * a file that does not end with a newline is copied to "tail" so that
+ * strtod/strtol never read past the end of the mapping.
+ */
+struct TextChunk {
+	const char *begin;
+	const char *end;
+	std::string tail;
+};
+
+void splitLines(const MappedFile &file, int maxChunks, std::vector<TextChunk> &chunks) {
+	const char *begin = file.data();
+	const char *end = begin + file.size();
+
+	//Move an unterminated last line to the last chunk's tail
+	const char *bodyEnd = end;
+	while(bodyEnd > begin && bodyEnd[-1] != '\n') {--bodyEnd;}
+
+	size_t bodySize = bodyEnd - begin;
+	int numChunks = std::min<size_t>(maxChunks, bodySize / MIN_CHUNK_BYTES + 1);
+	chunks.resize(numChunks);
+	const char *p = begin;
+
+	for(int c = 0; c < numChunks; ++c) {
+		const char *q = (c == numChunks - 1)
+			?bodyEnd :std::max(p, begin + bodySize * (c + 1) / numChunks);
+		while(q < bodyEnd && q > begin && q[-1] != '\n') {++q;}
+
+		chunks[c].begin = p;
+		chunks[c].end = q;
+		p = q;
+	}
+
+	chunks.back().tail.assign(bodyEnd, end);
+}
+
+/**
+ * Examples parsed from a chunk of a libsvm file.
+ * rowPtr is relative to the chunk and starts with 0.
+ */
+struct SvmChunk {
+	std::vector<double> labels;
+	std::vector<long long> rowPtr;
+	std::vector<int> indices;
+	std::vector<double> values;
+	int numFeatures;
+};
+
+void sortRow(SvmChunk &out, size_t rowStart, std::vector<pair<int, double> > &buffer) {
+	buffer.clear();
+	for(size_t k = rowStart; k < out.indices.size(); ++k) {
+		buffer.push_back(make_pair(out.indices[k], out.values[k]));
+	}
+
+	sort(buffer.begin(), buffer.end());
+
+	for(size_t k = 0; k < buffer.size(); ++k) {
+		out.indices[rowStart + k] = buffer[k].first;
+		out.values[rowStart + k] = buffer[k].second;
+	}
+}
 
-	vector<vector<int> > indices;
-	vector<vector<double> > vals;
+/**
+ * Parses "<label> <index>:<value> ..." lines in [p, end) without
+ * allocating per token. Blank lines are skipped.
+ */
+void parseSvmLines(const char *p, const char *end, SvmChunk &out) {
+	std::vector<pair<int, double> > sortBuffer;
 
-	while(getline(in, line)) {
-		++linenum;
-		double label;
-		vector<string> tokens;
-		istringstream linestream(line);
+	while(p < end) {
+		while(p < end && (isBlank(*p) || *p == '\n')) {++p;}
+		if(p >= end) {break;}
 
-		while(getline(linestream, token, ' ')) {			
-			tokens.push_back(token);
+		char *next;
+		double label = strtod(p, &next);
+		ASSERT(next != p, "Invalid label near: " << std::string(p, std::min<size_t>(end - p, 20)));
+		p = next;
+
+		out.labels.push_back(label);
+		size_t rowStart = out.indices.size();
+		bool sorted = true;
+
+		while(true) {
+			while(p < end && isBlank(*p)) {++p;}
+			if(p >= end || *p == '\n') {break;}
+
+			long idx = strtol(p, &next, 10);
+
+			if(next == p || *next != ':') {
+				//Not an index:value pair (e.g. qid:...), skip the token
+				while(p < end && !isBlank(*p) && *p != '\n') {++p;}
+				continue;
+			}
+
+			//strtod skips leading whitespace, which could run into the next line
+			ASSERT(next + 1 < end && !isBlank(next[1]) && next[1] != '\n',
+				   "Missing value near: " << std::string(p, std::min<size_t>(end - p, 20)));
+			double val = strtod(next + 1, &next);
+			p = next;
+
+			int idx0 = static_cast<int>(idx) - 1;
+			ASSERT(idx0 >= 0, "Feature indices must be positive. index=" << idx);
+			if(out.indices.size() > rowStart && out.indices.back() >= idx0) {
+				sorted = false;
+			}
+
+			out.indices.push_back(idx0);
+			out.values.push_back(val);
+			if(idx > out.numFeatures) {out.numFeatures = idx;}
 		}
 
-		label = atof(tokens[0].c_str());
-		labels.push_back(label);
+		//libsvm files list features in increasing order, but do not rely on it
+		if(!sorted) {sortRow(out, rowStart, sortBuffer);}
+		out.rowPtr.push_back(out.indices.size());
+	}
+}
+
+void parseSvmChunk(const TextChunk &chunk, SvmChunk &out) {
+	out.rowPtr.assign(1, 0);
+	out.numFeatures = -1;
+	parseSvmLines(chunk.begin, chunk.end, out);
+
+	if(!chunk.tail.empty()) {
+		parseSvmLines(chunk.tail.c_str(), chunk.tail.c_str() + chunk.tail.size(), out);
+	}
+}
+
+/**
+ * Rows parsed from a chunk of a CSV file, stored row by row.
+ */
+struct CsvChunk {
+	std::vector<double> values;
+	int numRows;
+	int numCols;
+};
 
-		indices.push_back(vector<int>());
-		vals.push_back(vector<double>());
+void parseCsvLines(const char *p, const char *end, CsvChunk &out) {
+	while(p < end) {
+		while(p < end && (isBlank(*p) || *p == '\n')) {++p;}
+		if(p >= end) {break;}
 
-		vector<int> &idcs = indices.back();
-		vector<double> &vls = vals.back();
-	
-		for(size_t i = 1; i < tokens.size(); ++i) {
-			size_t colon = tokens[i].find(':');
-			ASSERT(colon > 0, "line=" << linenum << " i=" << i << " token=" << tokens[i]);
+		int cols = 0;
 
-			char *str = const_cast<char *>(tokens[i].c_str());
-			str[colon] = 0;
-			int idx = atoi(str);
-			double val = atof(str + colon + 1);
+		while(true) {
+			char *next;
+			double val = strtod(p, &next);
+			ASSERT(next != p, "Invalid value near: " << std::string(p, std::min<size_t>(end - p, 20)));
+			out.values.push_back(val);
+			++cols;
 
-			idcs.push_back(idx-1);
-			vls.push_back(val);
-			if(idx > numFeatures) {numFeatures = idx;}   		
+			p = next;
+			while(p < end && isBlank(*p)) {++p;}
+			if(p < end && *p == ',') {++p;}
+			else {break;}
 		}
 
-		if(linenum % 1000 == 0) {LOG("Read " << linenum << " examples");}
+		assert(out.numCols == cols || out.numCols == -1);
+		out.numCols = cols;
+		++out.numRows;
 	}
+}
 
-	LOG("# of features = " << numFeatures);
+void parseCsvChunk(const TextChunk &chunk, CsvChunk &out) {
+	out.numRows = 0;
+	out.numCols = -1;
+	parseCsvLines(chunk.begin, chunk.end, out);
+
+	if(!chunk.tail.empty()) {
+		parseCsvLines(chunk.tail.c_str(), chunk.tail.c_str() + chunk.tail.size(), out);
+	}
+}
+
+}
+
+void SVMUtils::readSvmFile(const char *fileName, CsrDataset &data, std::vector<double> &labels, int &numFeatures) {
+	MappedFile file(fileName);
+	std::vector<TextChunk> chunks;
+	splitLines(file, Platform::getNumLocalThreads(), chunks);
+	int numChunks = chunks.size();
+
+	std::vector<SvmChunk> parsed(numChunks);
+
+	#pragma omp parallel for schedule(static, 1)
+	for(int c = 0; c < numChunks; ++c) {
+		parseSvmChunk(chunks[c], parsed[c]);
+	}
+
+	//Stitch chunks into a single CSR structure
+	std::vector<int> rowOffset(numChunks + 1, 0);
+	std::vector<long long> nnzOffset(numChunks + 1, 0);
+	numFeatures = -1;
+
+	for(int c = 0; c < numChunks; ++c) {
+		rowOffset[c+1] = rowOffset[c] + parsed[c].labels.size();
+		nnzOffset[c+1] = nnzOffset[c] + parsed[c].indices.size();
+		if(parsed[c].numFeatures > numFeatures) {numFeatures = parsed[c].numFeatures;}
+	}
+
+	int numRows = rowOffset[numChunks];
+	std::vector<long long> rowPtr(numRows + 1);
+	std::vector<int> indices(nnzOffset[numChunks]);
+	std::vector<double> values(nnzOffset[numChunks]);
+	labels.resize(numRows);
+	rowPtr[0] = 0;
 
-	for(size_t i = 0; i < indices.size(); ++i) {
-		data.push_back(SparseVector<double>(numFeatures));		
-		SparseVector<double> &newVector = data.back();
+	#pragma omp parallel for schedule(static, 1)
+	for(int c = 0; c < numChunks; ++c) {
+		const SvmChunk &chunk = parsed[c];
+		std::copy(chunk.labels.begin(), chunk.labels.end(), labels.begin() + rowOffset[c]);
+		std::copy(chunk.indices.begin(), chunk.indices.end(), indices.begin() + nnzOffset[c]);
+		std::copy(chunk.values.begin(), chunk.values.end(), values.begin() + nnzOffset[c]);
 
-		for(size_t j = 0; j < indices[i].size(); ++j) {
-			newVector.insert(indices[i][j]) = vals[i][j];
-		}		
+		for(size_t r = 1; r < chunk.rowPtr.size(); ++r) {
+			rowPtr[rowOffset[c] + r] = nnzOffset[c] + chunk.rowPtr[r];
+		}
 	}
+
+	data.assign(std::move(rowPtr), std::move(indices), std::move(values),
+				std::max(numFeatures, 0));
+
+	LOG("Read " << numRows << " examples using " << numChunks << " chunks");
+	LOG("# of features = " << numFeatures);
 }
 
 void SVMUtils::readCsvFile(const char *fileName, std::vector<Eigen::VectorXd> &data, std::vector<double> &labels) {
-	ifstream in(fileName);
-	//TODO: Check file
+	MappedFile file(fileName);
+	std::vector<TextChunk> chunks;
+	splitLines(file, Platform::getNumLocalThreads(), chunks);
+	int numChunks = chunks.size();
 
-	string line, token;
-	int lastDim = -1;
-	int num0 = 0;
-	int num1 = 1;
+	std::vector<CsvChunk> parsed(numChunks);
 
-	while(getline(in, line)) 
-	{
-		vector<string> tokens;
-		istringstream linestream(line);
+	#pragma omp parallel for schedule(static, 1)
+	for(int c = 0; c < numChunks; ++c) {
+		parseCsvChunk(chunks[c], parsed[c]);
+	}
 
-		while(getline(linestream, token, ',')) {
-			tokens.push_back(token);
-		}
+	std::vector<int> rowOffset(numChunks + 1, 0);
+	int lastDim = -1;
 
-		int dim = tokens.size() - 1;
+	for(int c = 0; c < numChunks; ++c) {
+		rowOffset[c+1] = rowOffset[c] + parsed[c].numRows;
+		if(parsed[c].numRows == 0) {continue;}
+
+		int dim = parsed[c].numCols - 1;
 		assert(dim == lastDim || lastDim == -1);
 		lastDim = dim;
+	}
 
-		data.push_back(VectorXd(dim));
-		VectorXd &instance = data.back();
-
-		for(int i = 0; i < dim; i++) {
-			instance(i) = atof(tokens[i].c_str());
-		}
+	size_t dataOffset = data.size();
+	data.resize(dataOffset + rowOffset[numChunks]);
+	labels.resize(dataOffset + rowOffset[numChunks]);
+	int num0 = 0;
+	int num1 = 0;
 
-		double label = atof(tokens[dim].c_str());
-		if(label == 0.0) {label = -1.0;}
+	#pragma omp parallel for schedule(static, 1) reduction(+:num0,num1)
+	for(int c = 0; c < numChunks; ++c) {
+		const CsvChunk &chunk = parsed[c];
+		int dim = chunk.numCols - 1;
 
-		assert(label == -1.0 || label == 1.0);
+		for(int r = 0; r < chunk.numRows; ++r) {
+			const double *row = chunk.values.data() + (size_t) r * chunk.numCols;
+			data[dataOffset + rowOffset[c] + r] = Eigen::Map<const VectorXd>(row, dim);
 
-		labels.push_back(label);
+			double label = row[dim];
+			if(label == 0.0) {label = -1.0;}
+			assert(label == -1.0 || label == 1.0);
+			labels[dataOffset + rowOffset[c] + r] = label;
 
-		if(label == -1.0) {++num0;}
-		else {++num1;}
+			if(label == -1.0) {++num0;}
+			else {++num1;}
+		}
 	}
 
 	assert(data.size() == labels.size());
 	assert(num0 > 0);
-	assert(num1 > 1);
+	assert(num1 > 0);
+}
+
+void SVMUtils::writeSvmCache(const char *fileName, const CsrDataset &data, const std::vector<double> &labels) {
+	ASSERT(labels.size() == static_cast<size_t>(data.size()), labels.size() << " != " << data.size());
+
+	ofstream out(fileName, ios::binary | ios::trunc);
+	if(!out) {throw FileFormatException(string("Cannot create ") + fileName);}
+
+	SvmCacheHeader header;
+	std::fill(reinterpret_cast<char *>(&header), reinterpret_cast<char *>(&header + 1), 0);
+	std::copy(CACHE_MAGIC, CACHE_MAGIC + 8, header.magic);
+	header.version = CACHE_VERSION;
+	header.byteOrder = CACHE_BYTE_ORDER;
+	header.numRows = data.size();
+	header.numFeatures = data.numFeatures();
+	header.nnz = data.nonZeros();
+
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	writePadded(out, labels.data(), header.numRows * sizeof(double));
+	writePadded(out, data.rowPtrData(), (header.numRows + 1) * sizeof(long long));
+	writePadded(out, data.indexData(), header.nnz * sizeof(int));
+	writePadded(out, data.valueData(), header.nnz * sizeof(double));
+
+	if(!out) {throw FileFormatException(string("Failed writing ") + fileName);}
 }
 
+void SVMUtils::mapSvmCache(const char *fileName, CsrDataset &data, std::vector<double> &labels, int &numFeatures) {
+	std::shared_ptr<const MappedFile> file(new MappedFile(fileName));
+
+	if(file->size() < sizeof(SvmCacheHeader)) {
+		throw FileFormatException(string("Truncated cache file ") + fileName);
+	}
+
+	const SvmCacheHeader *header = reinterpret_cast<const SvmCacheHeader *>(file->data());
+
+	if(!std::equal(CACHE_MAGIC, CACHE_MAGIC + 8, header->magic)
+	   || header->version != CACHE_VERSION || header->byteOrder != CACHE_BYTE_ORDER) {
+		throw FileFormatException(string("Not a compatible cache file ") + fileName);
+	}
+
+	//Bound the counts by the file size before computing any offsets from them
+	long long numRows = header->numRows;
+	long long nnz = header->nnz;
+	long long numFeatures64 = header->numFeatures;
+	if(numRows < 0 || numRows > INT_MAX || numFeatures64 < 0 || numFeatures64 > INT_MAX
+	   || nnz < 0 || static_cast<unsigned long long>(nnz) > file->size() / (sizeof(int) + sizeof(double))
+	   || static_cast<unsigned long long>(numRows) > file->size() / sizeof(double)) {
+		throw FileFormatException(string("Invalid header in cache file ") + fileName);
+	}
+
+	size_t labelsOffset = sizeof(SvmCacheHeader);
+	size_t rowPtrOffset = labelsOffset + align8(numRows * sizeof(double));
+	size_t indicesOffset = rowPtrOffset + align8((numRows + 1) * sizeof(long long));
+	size_t valuesOffset = indicesOffset + align8(nnz * sizeof(int));
+	size_t end = valuesOffset + align8(nnz * sizeof(double));
+
+	if(file->size() < end) {
+		throw FileFormatException(string("Truncated cache file ") + fileName);
+	}
+
+	const long long *rowPtr = reinterpret_cast<const long long *>(file->data() + rowPtrOffset);
+	const int *indices = reinterpret_cast<const int *>(file->data() + indicesOffset);
+
+	if(rowPtr[0] != 0 || rowPtr[numRows] != nnz) {
+		throw FileFormatException(string("Invalid row offsets in cache file ") + fileName);
+	}
+	for(long long r = 0; r < numRows; ++r) {
+		if(rowPtr[r] > rowPtr[r+1]) {
+			throw FileFormatException(string("Invalid row offsets in cache file ") + fileName);
+		}
+	}
+	for(long long k = 0; k < nnz; ++k) {
+		if(indices[k] < 0 || indices[k] >= numFeatures64) {
+			throw FileFormatException(string("Feature index out of range in cache file ") + fileName);
+		}
+	}
+
+	const double *labelData = reinterpret_cast<const double *>(file->data() + labelsOffset);
+	labels.assign(labelData, labelData + numRows);
+
+	data.attach(file, static_cast<int>(numRows), static_cast<int>(numFeatures64), rowPtr, indices,
+				reinterpret_cast<const double *>(file->data() + valuesOffset));
+	numFeatures = static_cast<int>(numFeatures64);
+
+	LOG("Mapped " << data.size() << " examples, # of features = " << numFeatures);
+}
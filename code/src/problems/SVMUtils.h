@@ -3,11 +3,27 @@
 
 #include <Eigen/Dense>
 #include <Eigen/SparseCore>
+#include "problems/CsrDataset.h"
 
 class SVMUtils {
  public:
 	static void readCsvFile(const char *fileName, std::vector<Eigen::VectorXd> &data, std::vector<double> &labels);
-	static void readSvmFile(const char *fileName, std::vector<Eigen::SparseVector<double> > &data, std::vector<double> &labels, int &numFeatures);	
+	static void readSvmFile(const char *fileName, CsrDataset &data, std::vector<double> &labels, int &numFeatures);
+
+	/**
+	Writes a dataset and its labels to a binary cache file that can be loaded
+	with mapSvmCache. The file holds a fixed-size header followed by the labels,
+	row pointers, feature indices and values, each 8-byte aligned, in the native
+	byte order of the machine.
+	*/
+	static void writeSvmCache(const char *fileName, const CsrDataset &data, const std::vector<double> &labels);
+
+	/**
+	Memory-maps a file written by writeSvmCache. The dataset refers directly to
+	the mapped file, so no parsing or copying of feature data takes place.
+	Throws FileFormatException if the file is missing or malformed.
+	*/
+	static void mapSvmCache(const char *fileName, CsrDataset &data, std::vector<double> &labels, int &numFeatures);
 };
 
 #endif
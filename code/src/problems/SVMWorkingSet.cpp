@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "problems/SVMWorkingSet.h"
+
+namespace {
+
+//Keeps the k entries with the largest scores, sorted by decreasing score
+void selectTop(std::vector<std::pair<double, int> > &scored, int k, std::vector<int> &out) {
+	typedef std::pair<double, int> Entry;
+	auto greater = [] (const Entry &a, const Entry &b) {return a.first > b.first;};
+
+	if(static_cast<int>(scored.size()) > k) {
+		std::nth_element(scored.begin(), scored.begin() + k, scored.end(), greater);
+		scored.resize(k);
+	}
+
+	std::sort(scored.begin(), scored.end(), greater);
+	out.clear();
+	for(const Entry &e : scored) {out.push_back(e.second);}
+}
+
+}
+
+SVMViolationIndex::SVMViolationIndex(int numCandidates, int rebuildPeriod, int rescanSlice)
+	: numCandidates_(numCandidates), rebuildPeriod_((rebuildPeriod > 0) ?rebuildPeriod :numCandidates),
+	  rescanSlice_(rescanSlice), up_(new std::atomic<int>[numCandidates]), low_(new std::atomic<int>[numCandidates]),
+	  numVars_(0), numUp_(0), numLow_(0), gap_(0.0), pendingRebuild_(false),
+	  updates_(Platform::getNumLocalThreads()), cursor_(0), sweepMax_(-INFINITY), sweepMin_(INFINITY) {}
+
+void SVMViolationIndex::rebuild(int numVars, const ActiveSet *activeSet, const double *alpha,
+		const double *y, double C, const DualGradient &gradient, bool full) {
+	rebuildLock_.lock();
+	int n = activeSet ?activeSet->size() :numVars;
+	bool partial = !full && rescanSlice_ > 0 && rescanSlice_ < n;
+
+	//A partial rebuild scans the current candidates and the next slice
+	slice_.clear();
+	if(partial) {
+		for(int k = 0; k < numUp_.load(std::memory_order_relaxed); ++k) {slice_.push_back(up_[k].load(std::memory_order_relaxed));}
+		for(int k = 0; k < numLow_.load(std::memory_order_relaxed); ++k) {slice_.push_back(low_[k].load(std::memory_order_relaxed));}
+
+		if(cursor_ >= n) {cursor_ = 0;}
+		for(int k = 0; k < rescanSlice_; ++k) {
+			int pos = cursor_ + k;
+			if(pos >= n) {pos -= n;}
+			slice_.push_back(activeSet ?(*activeSet)[pos] :pos);
+		}
+
+		std::sort(slice_.begin(), slice_.end());
+		slice_.erase(std::unique(slice_.begin(), slice_.end()), slice_.end());
+	}
+
+	std::vector<std::pair<double, int> > up, low;
+	int numScanned = partial ?static_cast<int>(slice_.size()) :n;
+	double m = -INFINITY, M = INFINITY;
+
+	for(int k = 0; k < numScanned; ++k) {
+		int t = partial ?slice_[k] :(activeSet ?(*activeSet)[k] :k);
+		double v = -y[t] * gradient(t);
+		bool inUp = (y[t] > 0) ?(alpha[t] < C) :(alpha[t] > 0.0);
+		bool inLow = (y[t] > 0) ?(alpha[t] > 0.0) :(alpha[t] < C);
+
+		if(inUp) {up.push_back(std::make_pair(v, t)); m = std::max(m, v);}
+		if(inLow) {low.push_back(std::make_pair(-v, t)); M = std::min(M, v);}
+	}
+
+	std::vector<int> topUp, topLow;
+	selectTop(up, numCandidates_, topUp);
+	selectTop(low, numCandidates_, topLow);
+
+	//The gap is only published once all variables have been seen
+	bool sweepDone = true;
+	if(partial) {
+		sweepMax_ = std::max(sweepMax_, m);
+		sweepMin_ = std::min(sweepMin_, M);
+		cursor_ += rescanSlice_;
+		sweepDone = cursor_ >= n;
+		if(sweepDone) {
+			cursor_ -= n;
+			m = sweepMax_;
+			M = sweepMin_;
+		}
+	}
+
+	if(sweepDone) {
+		if(!partial) {cursor_ = 0;}
+		sweepMax_ = -INFINITY;
+		sweepMin_ = INFINITY;
+	}
+
+	//Readers may use the old counts until the new ones are published; entries
+	//beyond the new counts keep their old (still valid) values
+	for(size_t k = 0; k < topUp.size(); ++k) {up_[k].store(topUp[k], std::memory_order_relaxed);}
+	for(size_t k = 0; k < topLow.size(); ++k) {low_[k].store(topLow[k], std::memory_order_relaxed);}
+	numVars_.store(numVars, std::memory_order_relaxed);
+	numUp_.store(topUp.size(), std::memory_order_release);
+	numLow_.store(topLow.size(), std::memory_order_release);
+	if(sweepDone) {gap_.store((m == -INFINITY || M == INFINITY) ?0.0 :m - M, std::memory_order_relaxed);}
+	rebuildLock_.unlock();
+}
+
+void MaxViolatingPairs::getPairs(int out_i[], int out_j[], int &n) {
+	int numUp = index_->numUp();
+	int numLow = index_->numLow();
+	assert(numUp > 0 && numLow > 0);
+	n = 1;
+
+	long long rank = threadId_ + numCalls_ * numThreads_;
+	++numCalls_;
+
+	int i = index_->up(rank % numUp);
+	int j = secondOrder_ ?selectSecond(i) :index_->low(rank % numLow);
+
+	//Free variables belong to both sets
+	if(j == i || j < 0) {j = index_->low((rank + 1) % numLow);}
+	if(j == i) {j = index_->up((rank + 1) % numUp);}
+
+	if(j == i) {
+		int numVars = index_->numVars();
+		assert(numVars >= 2);
+		j = r_.bounded(numVars - 1);
+		if(j >= i) {++j;}
+	}
+
+	out_i[0] = i;
+	out_j[0] = j;
+}
+
+int MaxViolatingPairs::selectSecond(int i) {
+	int numLow = index_->numLow();
+	double gMax = -y_[i] * gradient_(i);
+	double kii = kernel_(i, i);
+	int best = -1;
+	double bestDecrease = 0.0;
+
+	for(int k = 0; k < numLow; ++k) {
+		int t = index_->low(k);
+		if(t == i) {continue;}
+
+		double b = gMax + y_[t] * gradient_(t);
+		if(b <= 0.0) {continue;}
+
+		double a = kii + kernel_(t, t) - 2.0 * kernel_(i, t);
+		if(a <= 0.0) {a = 1e-12;}
+
+		double decrease = b * b / a;
+		if(decrease > bestDecrease) {
+			bestDecrease = decrease;
+			best = t;
+		}
+	}
+
+	return best;
+}
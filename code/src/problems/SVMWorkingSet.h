@@ -0,0 +1,149 @@
+#ifndef _RCD_SVMWORKINGSET_H_
+#define _RCD_SVMWORKINGSET_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "core/ActiveSet.h"
+#include "core/FastRandom.h"
+#include "core/PaddedArray.h"
+#include "core/SpinLock.h"
+#include "environments/PairSelectionFunc.h"
+#include "problems/KernelCache.h"
+
+typedef std::function<double(int)> DualGradient;
+
+/**
+ * Snapshot of the most violating variables of an SVM dual, used for working
+ * set selection. With G_t the dual gradient:
+ *  - up(k) holds variables that can increase y_t alpha_t, sorted by decreasing -y_t G_t.
+ *  - low(k) holds variables that can decrease y_t alpha_t, sorted by increasing -y_t G_t.
+ * Only the numCandidates most violating variables of each set are kept.
+ *
+ * The snapshot is rebuilt between blocks and, through countUpdate, by one
+ * worker thread at a time while the others keep updating. Selectors read it
+ * concurrently, so they may see a mix of two snapshots; every entry is still
+ * a valid candidate, and selectors re-evaluate the live gradient.
+ *
+ * If gradients are expensive (e.g. O(nnz) for the linear SVM), rebuilds made
+ * through countUpdate can be limited to a slice: they re-evaluate the current
+ * candidates and the next rescanSlice variables in cyclic order, so their
+ * cost does not grow with the number of variables. gap() is then taken over
+ * the last complete sweep of slices.
+ */
+class SVMViolationIndex {
+public:
+	/**
+	 * rebuildPeriod is the number of updates of a thread after which countUpdate
+	 * rebuilds the snapshot (numCandidates if not positive). A positive
+	 * rescanSlice limits partial rebuilds to a slice (see above).
+	 */
+	SVMViolationIndex(int numCandidates, int rebuildPeriod = 0, int rescanSlice = 0);
+
+	/**
+	 * Rebuilds the snapshot from the variables that are active in activeSet
+	 * (or all numVars variables if activeSet is null). Unless full is set,
+	 * only a slice is rescanned if a rescanSlice was given. Rebuilds by
+	 * different threads are serialized.
+	 */
+	void rebuild(int numVars, const ActiveSet *activeSet, const double *alpha,
+			const double *y, double C, const DualGradient &gradient, bool full = true);
+
+	/**
+	 * Counts an update made by the calling thread. Once the thread has made
+	 * rebuildPeriod updates it calls rebuild(), which must call rebuild above,
+	 * unless another thread is rebuilding already.
+	 */
+	template<class Rebuild>
+	void countUpdate(Rebuild rebuild) {
+		long long &n = updates_[Platform::getThreadId() % updates_.size()];
+		if(++n < rebuildPeriod_) {return;}
+
+		n = 0;
+		if(pendingRebuild_.exchange(true, std::memory_order_acquire)) {return;}
+		rebuild();
+		pendingRebuild_.store(false, std::memory_order_release);
+	}
+
+	/**
+	Number of variables of the problem, as given to the last rebuild.
+	*/
+	int numVars() const {return numVars_.load(std::memory_order_relaxed);}
+
+	int numUp() const {return numUp_.load(std::memory_order_acquire);}
+	int up(int k) const {return up_[k].load(std::memory_order_relaxed);}
+	int numLow() const {return numLow_.load(std::memory_order_acquire);}
+	int low(int k) const {return low_[k].load(std::memory_order_relaxed);}
+
+	/**
+	Maximal violation m - M at the time of the last rebuild (0 at optimality).
+	*/
+	double gap() const {return gap_.load(std::memory_order_relaxed);}
+
+private:
+	SVMViolationIndex(const SVMViolationIndex &);
+	SVMViolationIndex &operator=(const SVMViolationIndex &);
+
+	int numCandidates_;
+	long long rebuildPeriod_;
+	int rescanSlice_;
+
+	std::unique_ptr<std::atomic<int>[]> up_;
+	std::unique_ptr<std::atomic<int>[]> low_;
+	std::atomic<int> numVars_;
+	std::atomic<int> numUp_;
+	std::atomic<int> numLow_;
+	std::atomic<double> gap_;
+
+	SpinLock rebuildLock_; //Held for the whole rebuild
+	std::atomic<bool> pendingRebuild_; //A thread is inside countUpdate's rebuild
+	PaddedArray<long long> updates_; //Per thread, since the thread's last rebuild
+
+	//Partial rebuilds, guarded by rebuildLock_
+	int cursor_; //Position of the next slice in the active variables
+	double sweepMax_; //Bounds m and M of the violation seen in the current sweep
+	double sweepMin_;
+	std::vector<int> slice_;
+};
+
+/**
+ * Working set selection for the SVM dual. Each call returns a pair (i, j) with
+ * i taken from the up candidates and j from the low candidates of an
+ * SVMViolationIndex.
+ *
+ * With first order selection thread t pairs the candidates of rank
+ * t, t + numThreads, t + 2*numThreads, ... so that concurrent threads work on
+ * different variables. With second order selection i is chosen the same way
+ * and j maximizes the guaranteed decrease b^2/a (as in LIBSVM's WSS2) among the
+ * low candidates, evaluated with the live gradient.
+ *
+ * If the only candidate partner of i is i itself (e.g. a single free variable
+ * that is in both sets), j is drawn uniformly among the other variables.
+ */
+class MaxViolatingPairs : public PairSelection {
+public:
+	MaxViolatingPairs(const SVMViolationIndex *index, DualGradient gradient,
+			Kernel kernel, const double *y, int threadId, int numThreads, bool secondOrder)
+		: index_(index), gradient_(gradient), kernel_(kernel), y_(y),
+		  threadId_(threadId), numThreads_(numThreads), secondOrder_(secondOrder), numCalls_(0),
+		  r_(threadId) {}
+
+	virtual int getBufferSize() OVERRIDE {return 1;}
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE;
+
+private:
+	int selectSecond(int i);
+
+	const SVMViolationIndex *index_;
+	DualGradient gradient_;
+	Kernel kernel_;
+	const double *y_;
+	int threadId_;
+	int numThreads_;
+	bool secondOrder_;
+	long long numCalls_;
+	Xoshiro256 r_;
+};
+
+#endif
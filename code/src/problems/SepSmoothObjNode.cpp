@@ -69,7 +69,7 @@ SmoothObjMasterInfo SepSmoothObjNode::getInfoAsMaster(
 
 	info.AAT = &AAT;	
 	info.scaledGrad.reset(new VectorXd(varDim));
-	grad_(*input, *info.scaledGrad);
+	grad_(Map<const VectorXd>(input, varDim), *info.scaledGrad);
 	*info.scaledGrad /= L;
 	info.Ad.reset(new VectorXd());
 	*info.Ad = (*A) * (*info.scaledGrad);
@@ -99,7 +99,7 @@ void SepSmoothObjNode::updateAsSlave(int masterId,
 	}
 
 	VectorXd grad;
-	grad_(*input, grad);
+	grad_(Map<const VectorXd>(input, varDim), grad);
 	grad /= L;
 
 	Platform::sleepCurrentThread(50);
@@ -18,7 +18,7 @@ public:
 	: problem(problem) {}
 
 	void getNodeInput(int varId, SepSmoothNodeInput &nodeInput) OVERRIDE {
-		nodeInput = &(problem->x_[varId]);
+		nodeInput = problem->x_[varId].data();
 	}
 
 	DefaultStaticInput getNodeStaticInput(int varId) OVERRIDE {
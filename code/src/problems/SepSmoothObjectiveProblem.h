@@ -15,7 +15,8 @@ struct SmoothObjSlaveInfo {
 	const Eigen::MatrixXd *pairMatrix; //pinv(Ai Ai' / Li + Aj Aj' / Lj)
 };
 
-typedef const Eigen::VectorXd *SepSmoothNodeInput;
+//Pointer to the first entry of the node's block of variables
+typedef const double *SepSmoothNodeInput;
 
 struct SepSmoothObjInfoSpec {
 	typedef SmoothObjMasterInfo MasterInfo;
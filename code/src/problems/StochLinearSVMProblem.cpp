@@ -25,15 +25,20 @@ void StochLinearSVMNode::updateAsSlave(int masterId, const StochLinearSVMNode::M
 	const StochLinearSVMNode::NodeInput &input, StochLinearSVMNode::SlaveInfo& slaveInfo,
 	StochLinearSVMNode::Update& slaveUpdate) const {
 	int i = masterId; int j = varId_;
-	double alphai = input.alpha[i][0];
-	double alphaj = input.alpha[j][0];
+	double alphai, alphaj;
+	if(input.alphaSeq) {
+		input.alphaSeq->readPair(input.alpha, i, j, alphai, alphaj);
+	} else {
+		alphai = input.alpha[i];
+		alphaj = input.alpha[j];
+	}
 
 	double R = 0.0;
 	double Kii = masterInfo.kSelf;
 	double Kjj = kSelf_;
 
-	const auto &data_i = (*data_)[i];
-	const auto &data_j = (*data_)[j];
+	Data data_i = (*data_)[i];
+	Data data_j = (*data_)[j];
 
 	double Kij = data_i.dot(data_j);
 	double yi = y_[i];
@@ -48,11 +53,11 @@ void StochLinearSVMNode::updateAsSlave(int masterId, const StochLinearSVMNode::M
 	int k = stochGradK_;
 	stochGradK_ = (stochGradK_ + 1) % numVars_;
 
-	Data ddiff = data_i - data_j;
-	const auto &data_k = (*data_)[k];
+	Data data_k = (*data_)[k];
 
 	if(k != i && k != j) {
-		R = 0.5 * numVars_ * input.alpha[k][0] * y_[k] * yi * data_k.dot(ddiff);
+		double kdiff = data_k.dot(data_i) - data_k.dot(data_j);
+		R = 0.5 * numVars_ * input.alpha[k] * y_[k] * yi * kdiff;
 	}
 
 	double K_denom = (-Kii - Kjj + 2*Kij);
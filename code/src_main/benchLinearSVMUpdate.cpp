@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "CommandLineArgsReader.h"
+#include "core/Platform.h"
+#include "problems/LinearSVMProblem.h"
+
+using namespace std;
+using namespace Eigen;
+
+// Measures LinearSVMNode pair updates per second as a function of
+// the number of features, keeping the number of nonzeros per example fixed.
+// Only the node computations are timed; parameters are not modified.
+double benchmark(int numExamples, int numFeatures, int nnz, int numUpdates) {
+	std::default_random_engine r(0);
+	std::uniform_int_distribution<int> uf(0, numFeatures - 1);
+	std::uniform_real_distribution<double> uv(0.0, 1.0);
+
+	Dataset data;
+	data.reserve(numExamples, (long long) numExamples * nnz);
+
+	for(int i = 0; i < numExamples; ++i) {
+		vector<int> idx;
+		for(int k = 0; k < nnz; ++k) {idx.push_back(uf(r));}
+		sort(idx.begin(), idx.end());
+		idx.erase(unique(idx.begin(), idx.end()), idx.end());
+
+		vector<double> val;
+		for(size_t k = 0; k < idx.size(); ++k) {val.push_back(uv(r));}
+		data.addRow(idx.data(), val.data(), idx.size());
+	}
+
+	data.setNumFeatures(numFeatures);
+
+	LinearSVMProblem problem(&data, numFeatures, 1.0);
+	for(int i = 0; i < numExamples; ++i) {problem.y(i) = (i % 2) ?1.0 :-1.0;}
+
+	unique_ptr<ParameterReadClient<LinearSVMNodeInput, LinearSVMStaticInput> >
+		readClient(problem.createLocalParameterReadClient());
+	unique_ptr<ParameterUpdateClient> updateClient(problem.createLocalParameterUpdateClient());
+	vector<unique_ptr<RCDNode<LinearSVMInfoSpec> > > nodes;
+
+	for(int i = 0; i < numExamples; ++i) {
+		updateClient->init(i);
+		nodes.emplace_back(problem.createNode(i));
+		nodes.back()->init(0, readClient->getNodeStaticInput(i));
+	}
+
+	std::uniform_int_distribution<int> ui(0, numExamples - 1);
+	double checksum = 0.0;
+
+	Platform::Time start = Platform::getCurrentTime();
+
+	for(int u = 0; u < numUpdates; ++u) {
+		int i = ui(r), j = ui(r);
+		if(i == j) {j = (j + 1) % numExamples;}
+
+		LinearSVMNodeInput input;
+		readClient->getNodeInput(i, input);
+		SVMMasterInfo info_i = nodes[i]->getInfoAsMaster(j, input);
+		SVMSlaveInfo info_j;
+		VectorXd update_j;
+		nodes[j]->updateAsSlave(i, info_i, input, info_j, update_j);
+		checksum += update_j[0];
+	}
+
+	int timems = Platform::getDurationms(start, Platform::getCurrentTime());
+	LOG("checksum = " << checksum);
+	return numUpdates * 1000.0 / (timems > 0 ? timems : 1);
+}
+
+int main(int argc, const char **argv) {
+	CommandLineArgsReader argsReader;
+	argsReader.read(argc, argv);
+	int numExamples = atoi(argsReader.getParam("--num_examples", "1000").c_str());
+	int nnz = atoi(argsReader.getParam("--nnz", "50").c_str());
+	int numUpdates = atoi(argsReader.getParam("--updates", "1000000").c_str());
+	int maxFeatures = atoi(argsReader.getParam("--max_features", "10000000").c_str());
+
+	Platform::init();
+
+	for(int numFeatures = 1000; numFeatures <= maxFeatures; numFeatures *= 10) {
+		double rate = benchmark(numExamples, numFeatures, nnz, numUpdates);
+		cout << "numFeatures = " << numFeatures << " updates/sec = " << rate << endl;
+	}
+}
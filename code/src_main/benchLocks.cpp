@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CommandLineArgsReader.h"
+#include "core/McsLock.h"
+#include "core/PaddedArray.h"
+#include "core/Platform.h"
+#include "core/SpinLock.h"
+#include "core/TicketLock.h"
+#include "core/TtasLock.h"
+
+using namespace std;
+
+// Measures lock acquisitions per second under contention for every lock
+// type, sweeping the number of threads and the length of the critical
+// section. Each thread repeatedly takes a random lock out of --num_locks,
+// updates --cs_work doubles protected by it, releases it and then does
+// --outside_work units of private work. Fairness is the ratio of the
+// fewest to the most acquisitions made by a single thread.
+//
+// FIFO locks (ticket, MCS) hand the lock to a specific waiter, so their
+// throughput collapses when threads outnumber cores and that waiter is
+// descheduled. Run with at most one thread per core.
+
+// std::mutex behind the LockTable interface, for reference
+class MutexLock {
+public:
+	bool tryLock() {return !m_.try_lock();}
+	int lock() {m_.lock(); return 0;}
+	void unlock() {m_.unlock();}
+
+private:
+	std::mutex m_;
+};
+
+struct Result {
+	double opsPerSec;
+	double fairness;
+};
+
+template<class Lock>
+Result benchmark(int numThreads, int numLocks, int csWork, int outsideWork, int durationms) {
+	PaddedArray<Lock> locks(numLocks);
+	vector<vector<double> > shared(numLocks, vector<double>(csWork + 1, 0.0));
+	PaddedArray<long long> ops(numThreads);
+	std::atomic<bool> stop(false);
+	double sink = 0.0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto end = start + std::chrono::milliseconds(durationms);
+
+	#pragma omp parallel num_threads(numThreads) reduction(+:sink)
+	{
+		int tid = Platform::getThreadId();
+		unsigned seed = 12345u + 7919u * tid;
+		double local = tid;
+		long long n = 0;
+
+		while(!stop.load(std::memory_order_relaxed)) {
+			seed = seed * 1103515245u + 12345u;
+			int l = (seed >> 8) % numLocks;
+
+			locks[l].lock();
+			vector<double> &data = shared[l];
+			for(int k = 0; k <= csWork; ++k) {data[k] += 1.0;}
+			locks[l].unlock();
+
+			for(int k = 0; k < outsideWork; ++k) {local = local * 0.999 + 1.0;}
+			++n;
+
+			if(tid == 0 && (n & 63) == 0 && std::chrono::steady_clock::now() >= end) {
+				stop.store(true, std::memory_order_relaxed);
+			}
+		}
+
+		ops[tid] = n;
+		sink += local;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	//Every critical section incremented all entries of its lock's array once
+	long long total = 0, fewest = ops[0], most = ops[0];
+	for(int t = 0; t < numThreads; ++t) {
+		total += ops[t];
+		fewest = std::min(fewest, ops[t]);
+		most = std::max(most, ops[t]);
+	}
+
+	double check = 0.0;
+	for(int l = 0; l < numLocks; ++l) {check += shared[l][0];}
+	if(check != static_cast<double>(total)) {
+		cerr << "Mutual exclusion violated: " << check << " != " << total << endl;
+	}
+	LOG("sink = " << sink);
+
+	Result result;
+	result.opsPerSec = total / seconds;
+	result.fairness = most > 0 ?fewest / static_cast<double>(most) :1.0;
+	return result;
+}
+
+template<class Lock>
+void run(const string &name, const vector<int> &threads, int numLocks, int csWork,
+		int outsideWork, int durationms) {
+	for(int t : threads) {
+		Result r = benchmark<Lock>(t, numLocks, csWork, outsideWork, durationms);
+		cout << name << " threads = " << t << " cs_work = " << csWork
+			 << " ops/sec = " << r.opsPerSec << " fairness = " << r.fairness << endl;
+	}
+}
+
+vector<int> parseList(const string &list) {
+	vector<int> values;
+	stringstream ss(list);
+	string item;
+	while(getline(ss, item, ',')) {values.push_back(atoi(item.c_str()));}
+	return values;
+}
+
+int main(int argc, const char **argv) {
+	CommandLineArgsReader argsReader;
+	argsReader.read(argc, argv);
+	vector<int> threads = parseList(argsReader.getParam("--threads", "1,2,4,8"));
+	vector<int> csWorks = parseList(argsReader.getParam("--cs_work", "8,100,1000"));
+	int numLocks = atoi(argsReader.getParam("--num_locks", "4").c_str());
+	int outsideWork = atoi(argsReader.getParam("--outside_work", "200").c_str());
+	int durationms = atoi(argsReader.getParam("--duration_ms", "200").c_str());
+
+	Platform::init();
+
+	for(int csWork : csWorks) {
+		run<SpinLock>("spin", threads, numLocks, csWork, outsideWork, durationms);
+		run<TtasLock>("ttas", threads, numLocks, csWork, outsideWork, durationms);
+		run<TicketLock>("ticket", threads, numLocks, csWork, outsideWork, durationms);
+		run<McsLock>("mcs", threads, numLocks, csWork, outsideWork, durationms);
+		run<MutexLock>("mutex", threads, numLocks, csWork, outsideWork, durationms);
+	}
+}
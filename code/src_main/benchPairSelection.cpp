@@ -0,0 +1,94 @@
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "CommandLineArgsReader.h"
+#include "core/Platform.h"
+#include "environments/NetConfig.h"
+#include "environments/PairSelectionFunc.h"
+
+using namespace std;
+
+// Measures how many pairs per second the pair selectors produce on a
+// single thread, i.e. the per-update overhead of choosing a pair.
+
+// The previous implementation of RandomSinglePair, for reference
+class StdRandomSinglePair : public PairSelection {
+public:
+	StdRandomSinglePair(const NetConfig *config, int numVars, int seed)
+		: numVars_(numVars), config_(config), r_(seed) {}
+
+	virtual int getBufferSize() OVERRIDE {return 1;}
+	virtual void getPairs(int out_i[], int out_j[], int &n) OVERRIDE {
+		std::uniform_int_distribution<int> ui(0, numVars_ - 1);
+		int vi = ui(r_), vj;
+
+		if(config_) {
+			std::uniform_int_distribution<int> uj(0, config_->adjMatrix[vi].size() - 1);
+			vj = config_->adjMatrix[vi][uj(r_)];
+		} else {
+			std::uniform_int_distribution<int> uj(0, numVars_ - 2);
+			vj = uj(r_);
+			if(vj >= vi) {++vj;}
+		}
+
+		out_i[0] = vi;
+		out_j[0] = vj;
+		n = 1;
+	}
+
+private:
+	int numVars_;
+	const NetConfig *config_;
+	std::default_random_engine r_;
+};
+
+double benchmark(PairSelection *selector, long long numPairs) {
+	long long checksum = 0;
+	std::vector<int> out_i(selector->getBufferSize()), out_j(selector->getBufferSize());
+	Platform::Time start = Platform::getCurrentTime();
+
+	for(long long p = 0; p < numPairs; ) {
+		int n;
+		selector->getPairs(out_i.data(), out_j.data(), n);
+		checksum += out_i[0] ^ out_j[0];
+		p += n;
+	}
+
+	int timems = Platform::getDurationms(start, Platform::getCurrentTime());
+	LOG("checksum = " << checksum);
+	return numPairs * 1000.0 / (timems > 0 ? timems : 1);
+}
+
+int main(int argc, const char **argv) {
+	CommandLineArgsReader argsReader;
+	argsReader.read(argc, argv);
+	int numVars = atoi(argsReader.getParam("--num_vars", "100000").c_str());
+	long long numPairs = atoll(argsReader.getParam("--pairs", "100000000").c_str());
+
+	Platform::init();
+
+	NetConfig ring = NetConfig::createRing(numVars);
+	vector<double> weights(numVars);
+	for(int i = 0; i < numVars; ++i) {weights[i] = 1 + i % 7;}
+
+	vector<pair<string, unique_ptr<PairSelection> > > selectors;
+	selectors.emplace_back("std_clique", unique_ptr<PairSelection>(new StdRandomSinglePair(0, numVars, 0)));
+	selectors.emplace_back("std_ring", unique_ptr<PairSelection>(new StdRandomSinglePair(&ring, numVars, 0)));
+	selectors.emplace_back("single_clique", unique_ptr<PairSelection>(new RandomSinglePair(numVars, 0)));
+	selectors.emplace_back("single_ring", unique_ptr<PairSelection>(new RandomSinglePair(&ring, 0)));
+	selectors.emplace_back("weighted_clique", unique_ptr<PairSelection>(
+			new WeightedPairs(WeightedPairs::createTable(weights), 0, 0)));
+
+	NetConfig clique = NetConfig::createClique(std::min(numVars, 2000));
+	selectors.emplace_back("kpairs_ring", unique_ptr<PairSelection>(new RandomKPairs(&ring, 16, 0)));
+	selectors.emplace_back("kpairs_clique2000", unique_ptr<PairSelection>(new RandomKPairs(&clique, 16, 0)));
+	selectors.emplace_back("covering_ring", unique_ptr<PairSelection>(new CoveringPairs(&ring, 0)));
+	selectors.emplace_back("covering_clique2000", unique_ptr<PairSelection>(new CoveringPairs(&clique, 0)));
+
+	for(auto &s : selectors) {
+		double rate = benchmark(s.second.get(), numPairs);
+		cout << s.first << " pairs/sec = " << rate << endl;
+	}
+}
@@ -0,0 +1,38 @@
+#include "CommandLineArgsReader.h"
+#include "core/Platform.h"
+#include "problems/SVMUtils.h"
+
+using namespace std;
+
+// Converts a libsvm text file to the binary cache format read by
+// trainLinearSVM and trainSVM through --train_cache.
+int main(int argc, const char **argv) {
+	CommandLineArgsReader argsReader;
+	argsReader.read(argc, argv);
+	string fileName = argsReader.getParam("--train_file", "");
+	string cacheFileName = argsReader.getParam("--cache_file", "");
+	int numThreads = atoi(argsReader.getParam("--num_threads", "1").c_str());
+
+	if(fileName.empty() || cacheFileName.empty()) {
+		cerr << "Usage: " << argv[0] << " --train_file=<libsvm file> --cache_file=<output file>" << endl;
+		return -1;
+	}
+
+	Platform::init();
+	Platform::setNumLocalThreads(numThreads);
+
+	CsrDataset data; vector<double> y; int numFeatures;
+	SVMUtils::readSvmFile(fileName.c_str(), data, y, numFeatures);
+
+	try {
+		SVMUtils::writeSvmCache(cacheFileName.c_str(), data, y);
+	} catch(exception &x) {
+		cerr << x.what() << endl;
+		return -1;
+	}
+
+	cout << "Examples = " << data.size() << endl;
+	cout << "Features = " << numFeatures << endl;
+	cout << "Nonzeros = " << data.nonZeros() << endl;
+	return 0;
+}
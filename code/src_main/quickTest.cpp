@@ -88,6 +88,27 @@ int main(int argc, char **argv) {
 			} else {
 				test.syncPeriod = atoi(argv[idx++]);
 			}
+		} else if(strcmp(param, "sampling") == 0) {
+			if(idx == argc) {
+				cerr << "Command line option argument missing" << endl;
+				return -1;
+			} else {
+				test.sampling = (SamplingType) atoi(argv[idx++]);
+			}
+		} else if(strcmp(param, "records") == 0) {
+			if(idx == argc) {
+				cerr << "Command line option argument missing" << endl;
+				return -1;
+			} else {
+				test.numRecords = atoi(argv[idx++]);
+			}
+		} else if(strcmp(param, "pairs_file") == 0) {
+			if(idx == argc) {
+				cerr << "Command line option argument missing" << endl;
+				return -1;
+			} else {
+				test.pairsFile = argv[idx++];
+			}
 		} else {
 			cerr << "Invalid option: " << param << endl;
 			return -1;
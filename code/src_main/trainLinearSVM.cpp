@@ -2,6 +2,7 @@
 
 #include "CommandLineArgsReader.h"
 #include "environments/LocalAsyncScheduler.h"
+#include "environments/LocalMatchingScheduler.h"
 #include "problems/SVMUtils.h"
 #include "problems/StochLinearSVMProblem.h"
 #include "RCDIterationLogger.h"
@@ -14,27 +15,62 @@ int main(int argc, const char **argv) {
 	CommandLineArgsReader argsReader;
 	argsReader.read(argc, argv);
 	string fileName = argsReader.getParam("--train_file", "");
+	string cacheFileName = argsReader.getParam("--train_cache", "");
 	int numThreads = atoi(argsReader.getParam("--num_threads", "1").c_str());
+	int shrinking = atoi(argsReader.getParam("--shrinking", "0").c_str());
+	int wss = atoi(argsReader.getParam("--wss", "0").c_str());
+	int sampling = atoi(argsReader.getParam("--sampling", "0").c_str());
+	int wssCandidates = atoi(argsReader.getParam("--wss_candidates", "64").c_str());
+	int wssRebuild = atoi(argsReader.getParam("--wss_rebuild", "0").c_str());
+	double wssEps = atof(argsReader.getParam("--wss_eps", "1e-3").c_str());
+	int syncPeriod = atoi(argsReader.getParam("--sync_period", "-1").c_str());
+	int lockStripes = atoi(argsReader.getParam("--lock_stripes", "0").c_str());
+	string locking = argsReader.getParam("--locking", "double");
+	bool timings = static_cast<bool>(atoi(argsReader.getParam("--timings", "0").c_str()));
+	bool pinThreads = static_cast<bool>(atoi(argsReader.getParam("--pin_threads", "0").c_str()));
+	string traceFile = argsReader.getParam("--trace_file", "");
+	int traceEvents = atoi(argsReader.getParam("--trace_events", "262144").c_str());
 	int maxIterations = atoi(argsReader.getParam("--iterations", "1000000").c_str());
 	bool stochastic = static_cast<bool>(atoi(argsReader.getParam("--stoch", "0").c_str()));
+	bool atomicW = static_cast<bool>(atoi(argsReader.getParam("--atomic_w",
+			numThreads > 1 ? "1" : "0").c_str()));
 	
 	string minObjStr = argsReader.getParam("--min_obj", "ninf");
 	double minObj = -std::numeric_limits<double>::infinity();
 	if(minObjStr[0] != 'n') {minObj = atof(minObjStr.c_str());}
 
-	Dataset data; vector<double> y; int numFeatures;
-	SVMUtils::readSvmFile(fileName.c_str(), data, y, numFeatures);
+	//Each of these selects pairs in its own way
+	if(sampling > 0 && (wss > 0 || shrinking > 0)) {
+		cerr << "--sampling cannot be combined with --wss or --shrinking" << endl;
+		return -1;
+	}
 
-	int numExamples = data.size();
+	//The matching scheduler draws its own pairs
+	if(locking == "matching" && (wss > 0 || sampling > 0)) {
+		cerr << "--locking=matching cannot be combined with --wss or --sampling" << endl;
+		return -1;
+	}
 
 	Platform::init();
 	Platform::setNumLocalThreads(numThreads);
 	cerr << "Using " << Platform::getNumLocalThreads() << " threads" << endl;
 
-	typedef  LocalAsyncScheduler<LinearSVMInfoSpec> Scheduler;
+	Dataset data; vector<double> y; int numFeatures;
+	if(!cacheFileName.empty()) {
+		try {
+			SVMUtils::mapSvmCache(cacheFileName.c_str(), data, y, numFeatures);
+		} catch(FileFormatException &x) {
+			cerr << x.what() << endl;
+			return -1;
+		}
+	} else {
+		SVMUtils::readSvmFile(fileName.c_str(), data, y, numFeatures);
+	}
 
-	Scheduler *scheduler = new Scheduler(numExamples);
-	scheduler->setLockingLevel(Scheduler::DOUBLE);
+	int numExamples = data.size();
+
+	typedef  LocalAsyncScheduler<LinearSVMInfoSpec> Scheduler;
+	typedef  LocalMatchingScheduler<LinearSVMInfoSpec> MatchingScheduler;
 
 	std::unique_ptr<LinearSVMProblem> problem;
 	if(stochastic) {
@@ -47,10 +83,86 @@ int main(int argc, const char **argv) {
 		problem->y(i) = y[i];
 	}
 
+	problem->setAtomicWeightUpdates(atomicW);
+
+	if(shrinking > 0) {problem->enableShrinking(shrinking);}
+
+	RCDLocalScheduler<LinearSVMInfoSpec> *scheduler;
+	if(locking == "matching") {
+		//Bulk-synchronous rounds of disjoint pairs, which follow the active
+		//set if shrinking is enabled
+		MatchingScheduler *matching = new MatchingScheduler(numExamples);
+		matching->setSyncPeriod(syncPeriod);
+		matching->setCollectTimings(timings);
+		matching->setPinThreads(pinThreads);
+		scheduler = matching;
+	} else {
+		Scheduler *async;
+		if(wss > 0) {
+			//Working set selection (1: first order, 2: second order)
+			problem->enableWorkingSetSelection(wssCandidates, wssRebuild);
+			const SVMViolationIndex *index = problem->violationIndex();
+			auto *source = problem.get();
+			DualGradient gradient = [source] (int t) -> double {return source->gradient(t);};
+			const Dataset *dataPtr = &data;
+			Kernel linearKernel = [dataPtr] (int i, int j) -> double {return (*dataPtr)[i].dot((*dataPtr)[j]);};
+			Kernel kernel = linearKernel;
+			const double *labels = &problem->y(0);
+			PairSelectionFactory factory = [=] (int threadId, int numThreads) -> PairSelection * {
+				return new MaxViolatingPairs(index, gradient, kernel, labels, threadId, numThreads, wss > 1);};
+			async = new Scheduler(factory);
+		} else if(shrinking > 0) {
+			const ActiveSet *activeSet = problem->activeSet();
+			PairSelectionFactory factory = [activeSet] (int threadId, int numThreads) -> PairSelection * {
+				return new ActiveSetPairs(activeSet, threadId);};
+			async = new Scheduler(factory);
+		} else if(sampling > 0) {
+			//Importance sampling in proportion to K_ii
+			vector<double> weights(numExamples);
+			for(int i = 0; i < numExamples; ++i) {weights[i] = data[i].dot(data[i]);}
+			std::shared_ptr<const AliasTable> table = WeightedPairs::createTable(weights);
+			PairSelectionFactory factory = [table] (int threadId, int numThreads) -> PairSelection * {
+				return new WeightedPairs(table, 0, threadId);};
+			async = new Scheduler(factory);
+		} else {
+			async = new Scheduler(numExamples);
+		}
+
+		//Working set selection does not visit every variable, so blocks (and
+		//convergence checks) end after a pass worth of updates
+		if(wss > 0 && syncPeriod <= 0) {syncPeriod = numExamples;}
+		async->setSyncPeriod(syncPeriod);
+
+		if(locking == "optimistic") {
+			async->setLockingLevel(Scheduler::OPTIMISTIC);
+		} else if(locking == "double") {
+			async->setLockingLevel(Scheduler::DOUBLE);
+		} else if(locking == "single") {
+			async->setLockingLevel(Scheduler::SINGLE);
+		} else if(locking == "lock_free") {
+			async->setLockingLevel(Scheduler::LOCK_FREE);
+		} else {
+			cerr << "Unknown locking level: " << locking << endl;
+			return -1;
+		}
+		async->setLockStripes(lockStripes);
+		async->setCollectTimings(timings);
+		async->setPinThreads(pinThreads);
+		scheduler = async;
+	}
+
+	//Per-thread timeline of the solver, written as Chrome trace JSON
+	unique_ptr<TraceRecorder> trace;
+	if(!traceFile.empty()) {
+		trace.reset(new TraceRecorder(Platform::getNumLocalThreads(), traceEvents));
+		scheduler->setTraceRecorder(trace.get());
+	}
+
 	scheduler->readProblem(problem.get());
 	LOG("Processed data");
 
-	scheduler->setObjTolerance(0.0);
+	//With working set selection, stop once the maximal KKT violation is below wss_eps
+	scheduler->setObjTolerance(wss > 0 ?wssEps :0.0);
 	scheduler->setMaxIterations(maxIterations);
 	scheduler->setMinObjective(minObj);
 	RCDIterationLogger logger("/dev/null", 1);
@@ -59,6 +171,16 @@ int main(int argc, const char **argv) {
 	scheduler->deleteNodes();
 	delete scheduler;
 
+	if(trace) {
+		try {
+			trace->write(traceFile.c_str());
+			cerr << "Wrote " << trace->numEvents() << " trace events to " << traceFile
+				 << " (" << trace->numDropped() << " dropped)" << endl;
+		} catch(FileFormatException &x) {
+			cerr << "Warning: could not write trace: " << x.what() << endl;
+		}
+	}
+
 	cout << "Objective = " << out.objective << endl;
 	cout << "Iterations = " << out.numIterations << endl;
 	cout << "Time = " << (double) out.timems << endl;
@@ -0,0 +1,40 @@
+#include "core/ActiveSet.h"
+#include "environments/PairSelectionFunc.h"
+
+int main(int argc, char **argv) {
+	ActiveSet set(10, 3);
+	assert(set.size() == 10);
+
+	//Variables 0-4 get stuck, variable 4 recovers
+	for(int r = 0; r < 3; ++r) {
+		for(int i = 0; i < 5; ++i) {set.record(i, true);}
+	}
+	set.record(4, false);
+
+	//Variable 3 cannot be shrunk according to the problem
+	set.compact([] (int i) -> bool {return i != 3;});
+	assert(set.size() == 7);
+	for(int i = 0; i < 3; ++i) {assert(!set.isActive(i));}
+	for(int i = 3; i < 10; ++i) {assert(set.isActive(i));}
+
+	//Selectors only draw active variables
+	ActiveSetPairs selector(&set, 1);
+	for(int t = 0; t < 1000; ++t) {
+		int i, j, n;
+		selector.getPairs(&i, &j, n);
+		assert(n == 1 && i != j);
+		assert(set.isActive(i) && set.isActive(j));
+	}
+
+	//At least two variables stay active
+	for(int r = 0; r < 3; ++r) {
+		for(int i = 0; i < 10; ++i) {set.record(i, true);}
+	}
+	set.compact();
+	assert(set.size() == 7);
+
+	assert(set.restoreAll());
+	assert(set.size() == 10);
+	assert(!set.restoreAll());
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "environments/AliasTable.h"
+#include "environments/NetConfig.h"
+#include "environments/PairSelectionFunc.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	//Exact probabilities
+	vector<double> weights = {1.0, 0.0, 3.0, 4.0, 2.0};
+	AliasTable table(weights);
+	assert(table.numDistributions() == 1 && table.size() == 5);
+
+	for(int k = 0; k < 5; ++k) {
+		ASSERT_NEAR(table.probability(k), weights[k] / 10.0, 1e-12);
+	}
+
+	//Empirical frequencies
+	std::default_random_engine r(1);
+	vector<int> counts(5, 0);
+	int numSamples = 1000000;
+	for(int s = 0; s < numSamples; ++s) {++counts[table.sample(r)];}
+
+	assert(counts[1] == 0);
+	for(int k = 0; k < 5; ++k) {
+		ASSERT_NEAR(counts[k] / (double) numSamples, weights[k] / 10.0, 5e-3);
+	}
+
+	//Several distributions back to back; all-zero weights mean uniform
+	double second[] = {5.0, 5.0, 0.0};
+	double third[] = {0.0, 0.0};
+	assert(table.add(second, 3) == 1);
+	assert(table.add(third, 2) == 2);
+	ASSERT_NEAR(table.probability(0, 1), 0.5, 1e-12);
+	ASSERT_NEAR(table.probability(2, 1), 0.0, 1e-12);
+	ASSERT_NEAR(table.probability(1, 2), 0.5, 1e-12);
+	ASSERT_NEAR(table.probability(3), 0.4, 1e-12);
+
+	//Skewed weights with many zeros: zero weights are never drawn
+	{
+		std::default_random_engine rw(7);
+		std::uniform_real_distribution<double> exponent(-12.0, 12.0);
+		vector<double> skewed(2000, 0.0);
+		for(int k = 0; k < 2000; k += 7) {skewed[k] = std::pow(10.0, exponent(rw));}
+
+		AliasTable skewedTable(skewed);
+		for(int k = 0; k < 2000; ++k) {
+			if(skewed[k] == 0.0) {assert(skewedTable.probability(k) == 0.0);}
+		}
+
+		for(int s = 0; s < numSamples; ++s) {assert(skewed[skewedTable.sample(r)] > 0.0);}
+	}
+
+	//Weighted pairs respect the graph and the weights
+	int numVars = 50;
+	NetConfig chain = NetConfig::createChain(numVars);
+	vector<double> nodeWeights(numVars);
+	for(int i = 0; i < numVars; ++i) {nodeWeights[i] = 1 + i % 5;}
+
+	WeightedPairs pairs(WeightedPairs::createTable(nodeWeights, &chain), &chain, 3);
+	vector<int> selected(numVars, 0);
+	for(int s = 0; s < 300000; ++s) {
+		int i, j, n;
+		pairs.getPairs(&i, &j, n);
+		assert(n == 1);
+		assert(std::abs(i - j) == 1);
+		++selected[i];
+	}
+
+	//Node 4 has weight 5 and node 0 has weight 1
+	double ratio = selected[4] / (double) selected[0];
+	assert(ratio > 4.5 && ratio < 5.5);
+
+	//Clique: distinct pairs
+	WeightedPairs clique(WeightedPairs::createTable(nodeWeights), 0, 3);
+	for(int s = 0; s < 10000; ++s) {
+		int i, j, n;
+		clique.getPairs(&i, &j, n);
+		assert(i != j && i >= 0 && j >= 0 && i < numVars && j < numVars);
+	}
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "problems/CsrDataset.h"
+#include "problems/SVMUtils.h"
+
+using namespace std;
+using namespace Eigen;
+
+int main(int argc, char **argv) {
+	CsrDataset data;
+
+	int idx0[] = {0, 3};
+	double val0[] = {1.0, 2.0};
+	int idx2[] = {1, 3, 4};
+	double val2[] = {-1.0, 0.5, 4.0};
+
+	data.addRow(idx0, val0, 2);
+	data.addRow(0, 0, 0);
+	data.addRow(idx2, val2, 3);
+
+	assert(data.size() == 3);
+	assert(data.numFeatures() == 5);
+	assert(data.nonZeros() == 5);
+	assert(data[1].nonZeros() == 0);
+	assert(data[2].indices[1] == 3 && data[2].values[2] == 4.0);
+
+	ASSERT_NEAR(data[0].dot(data[2]), 1.0, 1e-12);
+	ASSERT_NEAR(data[2].dot(data[2]), 17.25, 1e-12);
+	ASSERT_NEAR(data[0].dot(data[1]), 0.0, 1e-12);
+
+	VectorXd w(5);
+	w << 1.0, 2.0, 3.0, 4.0, 5.0;
+	ASSERT_NEAR(data[0].dot(w), 9.0, 1e-12);
+	ASSERT_NEAR(data[2].dot(w), 20.0, 1e-12);
+
+	//Unsorted features are accepted from files
+	const char *fileName = "test_CsrDataset.svm";
+	{
+		ofstream out(fileName);
+		out << "+1 1:1 4:2" << endl;
+		out << "-1 5:4 2:-1 4:0.5" << endl;
+	}
+
+	CsrDataset fileData; vector<double> labels; int numFeatures;
+	SVMUtils::readSvmFile(fileName, fileData, labels, numFeatures);
+	remove(fileName);
+
+	assert(fileData.size() == 2);
+	assert(numFeatures == 5);
+	assert(labels[0] == 1.0 && labels[1] == -1.0);
+	ASSERT_NEAR(fileData[0].dot(fileData[1]), data[0].dot(data[2]), 1e-12);
+	ASSERT_NEAR(fileData[1].dot(w), data[2].dot(w), 1e-12);
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include "core/Platform.h"
+#include "problems/KernelCache.h"
+
+int main(int argc, char **argv) {
+	Platform::init();
+	Platform::setNumLocalThreads(4);
+
+	const int n = 1000;
+	Kernel kernel = [] (int i, int j) -> double {return 1.0 * i * j + 1.0;};
+
+	//Room for 10 rows
+	double budgetMB = 10.0 * n * sizeof(double) / (1024.0 * 1024.0);
+	KernelCache cache(n, kernel, budgetMB);
+
+	KernelCache::Row row = cache.getRow(3);
+	assert(row->size() == n);
+	for(int k = 0; k < n; ++k) {ASSERT_NEAR((*row)[k], kernel(3, k), 1e-12);}
+
+	assert(cache.getRow(3) == row);
+	assert(cache.getNumHits() == 1 && cache.getNumMisses() == 1);
+
+	for(int i = 0; i < 50; ++i) {cache.getRow(i);}
+	assert(cache.numCachedRows() == 10);
+	assert(cache.usedBytes() <= 10 * cache.rowBytes());
+	assert(cache.getNumEvictions() == 40);
+
+	//Evicted rows stay valid for their holders
+	ASSERT_NEAR((*row)[7], kernel(3, 7), 1e-12);
+
+	//Referenced rows get a second chance before eviction
+	KernelCache::Row row45 = cache.getRow(45);
+	cache.getRow(60);
+	long long hits = cache.getNumHits();
+	assert(cache.getRow(45) == row45);
+	assert(cache.getNumHits() == hits + 1);
+
+	//Concurrent access
+	#pragma omp parallel for
+	for(int t = 0; t < 20000; ++t) {
+		int i = (t * 7919) % 30;
+		KernelCache::Row r = cache.getRow(i);
+		ASSERT_NEAR((*r)[i], kernel(i, i), 1e-12);
+	}
+
+	assert(cache.numCachedRows() <= 10);
+
+	//A budget smaller than one row disables caching
+	cache.setBudget(0.0);
+	assert(cache.numCachedRows() == 0);
+	ASSERT_NEAR((*cache.getRow(5))[2], kernel(5, 2), 1e-12);
+	assert(cache.numCachedRows() == 0);
+	return 0;
+}
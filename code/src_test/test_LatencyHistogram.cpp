@@ -0,0 +1,27 @@
+#include "core/LatencyHistogram.h"
+
+int main(int argc, char **argv) {
+	LatencyHistogram h;
+	assert(h.count() == 0 && h.quantile(0.5) == 0);
+
+	//90 fast samples in [64, 128), 10 slow ones in [4096, 8192)
+	for(int k = 0; k < 90; ++k) {h.record(100);}
+	for(int k = 0; k < 10; ++k) {h.record(5000 + k);}
+	assert(h.count() == 100 && h.max() == 5009);
+
+	assert(h.quantile(0.5) == 127);
+	assert(h.quantile(0.9) == 127);
+	assert(h.quantile(0.99) == 5009); //Capped by the maximum
+
+	//Zero lands in the first bucket, huge values in the last
+	LatencyHistogram other;
+	other.record(0);
+	other.record(~0ull);
+	h.add(other);
+	assert(h.count() == 102 && h.max() == ~0ull);
+	assert(h.quantile(0.001) == 1);
+
+	h.reset();
+	assert(h.count() == 0 && h.max() == 0);
+	return 0;
+}
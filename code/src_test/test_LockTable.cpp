@@ -0,0 +1,97 @@
+#include <vector>
+
+#include "core/LockTable.h"
+#include "core/McsLock.h"
+#include "core/Platform.h"
+#include "core/TicketLock.h"
+#include "core/TtasLock.h"
+
+using namespace std;
+
+//Concurrent pair updates are mutually exclusive. FIFO locks hand over to
+//a specific waiter, which is slow when threads outnumber cores, so they
+//are run for fewer iterations.
+template<class Lock>
+void checkExclusion(int numOps) {
+	LockTable<Lock> small(8, 3);
+	assert(small.memoryBytes() == 3 * Platform::CACHE_LINE_SIZE);
+	vector<long long> counter(8, 0);
+
+	#pragma omp parallel for
+	for(int k = 0; k < numOps; ++k) {
+		int a = k % 8;
+		int b = (k / 8 + a + 1) % 8;
+		if(a == b) {continue;}
+
+		small.lockPair(a, b);
+		++counter[a];
+		++counter[b];
+		small.unlockPair(a, b);
+	}
+
+	long long total = 0;
+	for(long long c : counter) {total += c;}
+	int expected = 0;
+	for(int k = 0; k < numOps; ++k) {
+		if(k % 8 != (k / 8 + k % 8 + 1) % 8) {expected += 2;}
+	}
+
+	assert(total == expected);
+	assert(small.getNumContentions() >= 0 && small.getNumContentions() <= 2LL * numOps);
+}
+
+int main(int argc, char **argv) {
+	Platform::init();
+	Platform::setNumLocalThreads(4);
+
+	//One padded lock per variable
+	LockTable<> full(1000);
+	assert(full.numLocks() == 1000 && !full.isStriped());
+	assert(full.memoryBytes() == 1000 * Platform::CACHE_LINE_SIZE);
+	assert(full.stripe(123) == 123);
+
+	//Hashed stripes
+	LockTable<> striped(1000000, 64);
+	assert(striped.numLocks() == 64 && striped.isStriped());
+	assert(striped.memoryBytes() == 64 * Platform::CACHE_LINE_SIZE);
+
+	vector<int> hits(64, 0);
+	for(int i = 0; i < 1000000; ++i) {
+		int s = striped.stripe(i);
+		assert(s >= 0 && s < 64);
+		++hits[s];
+	}
+	for(int s = 0; s < 64; ++s) {assert(hits[s] > 0);}
+
+	//Pairs sharing a stripe are locked once
+	int i = 0, j = 1;
+	while(striped.stripe(j) != striped.stripe(i)) {++j;}
+	striped.lockPair(i, j);
+	striped.unlockPair(i, j);
+	striped.lockPair(j, i);
+	striped.unlockPair(j, i);
+
+	//Uncontended acquisitions are not counted
+	assert(striped.getNumContentions() == 0);
+
+	checkExclusion<SpinLock>(200000);
+	checkExclusion<TtasLock>(200000);
+	checkExclusion<TicketLock>(20000);
+	checkExclusion<McsLock>(20000);
+
+	//tryLock fails while the lock is held
+	TicketLock ticket;
+	assert(!ticket.tryLock() && ticket.tryLock());
+	ticket.unlock();
+	assert(ticket.lock() == 0);
+	ticket.unlock();
+
+	McsLock mcs1, mcs2;
+	assert(!mcs1.tryLock() && mcs1.tryLock());
+	assert(mcs2.lock() == 0);
+	mcs2.unlock();
+	mcs1.unlock();
+	assert(sizeof(McsLock) == Platform::CACHE_LINE_SIZE);
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <vector>
+#include <algorithm>
+
+#include "environments/MatchingSampler.h"
+#include "environments/NetConfig.h"
+#include "environments/PairSelectionFunc.h"
+
+using namespace std;
+
+bool isEdge(const NetConfig &config, int i, int j) {
+	const vector<int> &adj = config.adjMatrix[i];
+	return std::find(adj.begin(), adj.end(), j) != adj.end();
+}
+
+//Checks that the pairs are edges and pairwise disjoint
+void checkMatching(const NetConfig &config, const int *pi, const int *pj, int n) {
+	vector<int> seen(config.numVars, 0);
+
+	for(int p = 0; p < n; ++p) {
+		assert(isEdge(config, pi[p], pj[p]));
+		assert(++seen[pi[p]] == 1);
+		assert(++seen[pj[p]] == 1);
+	}
+}
+
+//No edge may join two unmatched vertices
+void checkMaximal(const NetConfig &config, const int *pi, const int *pj, int n) {
+	vector<bool> matched(config.numVars, false);
+	for(int p = 0; p < n; ++p) {matched[pi[p]] = matched[pj[p]] = true;}
+
+	for(int v = 0; v < config.numVars; ++v) {
+		if(matched[v]) {continue;}
+		for(int u : config.adjMatrix[v]) {assert(matched[u]);}
+	}
+}
+
+int main(int argc, char **argv) {
+	int numVars = 201;
+	vector<NetConfig> configs;
+	configs.push_back(NetConfig::createChain(numVars));
+	configs.push_back(NetConfig::createClique(numVars));
+	configs.push_back(NetConfig::createTree(numVars));
+	configs.push_back(NetConfig::createStar(numVars));
+	configs.push_back(NetConfig::createSuperTree(numVars));
+
+	vector<int> pi(numVars), pj(numVars);
+	Xoshiro256 r(5);
+
+	for(const NetConfig &config : configs) {
+		MatchingSampler sampler(&config);
+
+		//State is reused across many calls
+		for(int call = 0; call < 200; ++call) {
+			int n = sampler.sampleCovering(call % numVars, r, pi.data(), pj.data());
+			checkMatching(config, pi.data(), pj.data(), n);
+			checkMaximal(config, pi.data(), pj.data(), n);
+
+			n = sampler.sampleRandom(10, r, pi.data(), pj.data());
+			assert(n <= 10);
+			checkMatching(config, pi.data(), pj.data(), n);
+		}
+
+		//Disjoint batches for 4 threads
+		int batchSize = 8;
+		vector<int> bi(4 * batchSize), bj(4 * batchSize), sizes(4);
+		for(int call = 0; call < 50; ++call) {
+			int n = sampler.sampleBatches(4, batchSize, call % 2, r, bi.data(), bj.data(), sizes.data());
+			vector<int> flat_i, flat_j;
+
+			for(int b = 0; b < 4; ++b) {
+				assert(sizes[b] <= batchSize);
+				flat_i.insert(flat_i.end(), &bi[b * batchSize], &bi[b * batchSize] + sizes[b]);
+				flat_j.insert(flat_j.end(), &bj[b * batchSize], &bj[b * batchSize] + sizes[b]);
+			}
+
+			assert((int) flat_i.size() == n);
+			checkMatching(config, flat_i.data(), flat_j.data(), n);
+		}
+	}
+
+	//A clique has a perfect matching (but for one vertex) and random pairs cover all vertices
+	MatchingSampler clique(&configs[1]);
+	assert(clique.sampleCovering(0, r, pi.data(), pj.data()) == numVars / 2);
+
+	vector<int> hits(numVars, 0);
+	for(int call = 0; call < 2000; ++call) {
+		int n = clique.sampleRandom(5, r, pi.data(), pj.data());
+		assert(n == 5);
+		for(int p = 0; p < n; ++p) {++hits[pi[p]]; ++hits[pj[p]];}
+	}
+	for(int v = 0; v < numVars; ++v) {assert(hits[v] > 50 && hits[v] < 250);}
+
+	//Excluded vertices are never drawn, until the exclusion is lifted
+	vector<int> excluded;
+	for(int v = 0; v < numVars; v += 3) {excluded.push_back(v);}
+	clique.setExcluded(excluded);
+
+	for(int call = 0; call < 100; ++call) {
+		int n = (call % 2) ?clique.sampleRandom(numVars, r, pi.data(), pj.data())
+			:clique.sampleCovering(call % numVars, r, pi.data(), pj.data());
+		assert(n == (numVars - (int) excluded.size()) / 2);
+
+		for(int p = 0; p < n; ++p) {
+			assert(pi[p] % 3 != 0 && pj[p] % 3 != 0);
+		}
+	}
+
+	clique.setExcluded(vector<int>());
+	assert(clique.sampleCovering(0, r, pi.data(), pj.data()) == numVars / 2);
+
+	//Selectors built on the sampler
+	RandomKPairs kpairs(&configs[0], 7, 1);
+	CoveringPairs cover(&configs[0], 1);
+	for(int call = 0; call < 100; ++call) {
+		int n;
+		kpairs.getPairs(pi.data(), pj.data(), n);
+		assert(n == 7);
+		checkMatching(configs[0], pi.data(), pj.data(), n);
+
+		cover.getPairs(pi.data(), pj.data(), n);
+		assert(n <= cover.getBufferSize());
+		checkMaximal(configs[0], pi.data(), pj.data(), n);
+	}
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "environments/NetConfig.h"
+#include "environments/PairSelectionFunc.h"
+
+using namespace std;
+
+void checkSameSequence(PairSelection *a, PairSelection *b, int numRecords) {
+	assert(a->getBufferSize() == b->getBufferSize());
+	int bufSize = a->getBufferSize();
+	vector<int> ai(bufSize), aj(bufSize), bi(bufSize), bj(bufSize);
+
+	for(int k = 0; k < numRecords; ++k) {
+		int na, nb;
+		a->getPairs(ai.data(), aj.data(), na);
+		b->getPairs(bi.data(), bj.data(), nb);
+		assert(na == nb);
+		assert(std::equal(ai.begin(), ai.begin() + na, bi.begin()));
+		assert(std::equal(aj.begin(), aj.begin() + na, bj.begin()));
+	}
+}
+
+bool rejects(const char *fileName, int numVars) {
+	try {
+		OfflinePairs bad;
+		bad.load(fileName, numVars);
+	} catch(FileFormatException &x) {
+		return true;
+	}
+
+	return false;
+}
+
+//Overwrites the value at offset, checks that loading fails and restores it
+template<class T>
+bool rejectsPatched(const char *fileName, long offset, T value) {
+	T old;
+	fstream f(fileName, ios::in | ios::out | ios::binary);
+	f.seekg(offset);
+	f.read(reinterpret_cast<char *>(&old), sizeof(T));
+	f.seekp(offset);
+	f.write(reinterpret_cast<const char *>(&value), sizeof(T));
+	f.flush();
+
+	bool rejected = rejects(fileName, 100);
+	f.seekp(offset);
+	f.write(reinterpret_cast<const char *>(&old), sizeof(T));
+	return rejected;
+}
+
+int main(int argc, char **argv) {
+	const char *fileName = "test_OfflinePairs.bin";
+	NetConfig ring = NetConfig::createRing(100);
+
+	//Full records: no per-record counts are stored
+	RandomSinglePair base(&ring, 7);
+	OfflinePairs trace;
+	trace.init(&base, 1000, 100);
+	assert(trace.getNumRecords() == 1000 && trace.getBufferSize() == 1);
+	assert(trace.memoryBytes() == 2 * 1000 * sizeof(int));
+
+	RandomSinglePair expected(&ring, 7);
+	checkSameSequence(&trace, &expected, 1000);
+
+	//Cycles through the trace
+	RandomSinglePair expected2(&ring, 7);
+	checkSameSequence(&trace, &expected2, 10);
+
+	//Save and replay from a mapped file
+	OfflinePairs fresh;
+	fresh.init(&base, 1000, 100);
+	fresh.save(fileName);
+	OfflinePairs replay;
+	replay.load(fileName, 100);
+	assert(replay.isMapped());
+	assert(replay.getNumRecords() == 1000 && replay.getNumVars() == 100);
+	checkSameSequence(&fresh, &replay, 2500);
+
+	//Records of varying size
+	CoveringPairs cover(&ring, 3);
+	OfflinePairs coverTrace;
+	coverTrace.init(&cover, 50, 100);
+	coverTrace.save(fileName);
+	OfflinePairs coverReplay;
+	coverReplay.load(fileName, 100);
+	CoveringPairs coverExpected(&ring, 3);
+	checkSameSequence(&coverReplay, &coverExpected, 50);
+
+	//Malformed or mismatching traces are rejected
+	assert(rejects(fileName, 99));
+	assert(rejectsPatched<char>(fileName, 0, 'X'));
+	assert(rejectsPatched<long long>(fileName, 16, 1LL << 40));	//numRecords
+	assert(rejectsPatched<int>(fileName, 24, 1 << 30));	//bufSize
+	assert(rejectsPatched<int>(fileName, 32, 101));	//numVars
+	assert(rejectsPatched<int>(fileName, 64, cover.getBufferSize() + 1));	//Record size
+	assert(rejectsPatched<int>(fileName, 64, -1));
+
+	fresh.save(fileName);
+	assert(!rejects(fileName, 100));
+	assert(rejectsPatched<int>(fileName, 64 + 4 * 500, 100));	//pair_i[500]
+	assert(rejectsPatched<int>(fileName, 64 + 4 * 1000, -3));	//pair_j[0]
+	remove(fileName);
+
+	//Streaming gives the base sequence, even when the ring wraps around
+	StreamingPairs stream(new RandomSinglePair(&ring, 11), 16);
+	RandomSinglePair streamExpected(&ring, 11);
+	checkSameSequence(&stream, &streamExpected, 100000);
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "core/Platform.h"
+#include "problems/CsrDataset.h"
+#include "problems/SVMUtils.h"
+
+using namespace std;
+using namespace Eigen;
+
+void writeSvmFile(const char *fileName, int numExamples) {
+	ofstream out(fileName);
+
+	for(int i = 0; i < numExamples; ++i) {
+		out << ((i % 2) ?"+1" :"-1");
+		if(i % 10 == 0) {out << " qid:3";}
+
+		for(int k = 5 + i % 3; k < 40; k += 1 + i % 4) {
+			out << " " << k << ":" << (0.25 * k - i % 7);
+		}
+
+		if(i % 17 == 0) {out << " 2:7.5\r";} //Out of order feature
+		if(i < numExamples - 1) {out << "\n";}
+		if(i % 100 == 0) {out << "\n";} //Blank line
+	}
+}
+
+int main(int argc, char **argv) {
+	Platform::init();
+	const char *fileName = "test_ParseSvmFile.svm";
+	int numExamples = 20000;
+	writeSvmFile(fileName, numExamples);
+
+	//Serial and parallel parsing must give the same dataset
+	Platform::setNumLocalThreads(1);
+	CsrDataset data1; vector<double> labels1; int numFeatures1;
+	SVMUtils::readSvmFile(fileName, data1, labels1, numFeatures1);
+
+	Platform::setNumLocalThreads(4);
+	CsrDataset data4; vector<double> labels4; int numFeatures4;
+	SVMUtils::readSvmFile(fileName, data4, labels4, numFeatures4);
+	remove(fileName);
+
+	assert(data1.size() == numExamples);
+	assert(data4.size() == numExamples);
+	assert(labels1 == labels4);
+	assert(numFeatures1 == numFeatures4);
+	assert(data1.nonZeros() == data4.nonZeros());
+
+	for(int i = 0; i < numExamples; ++i) {
+		CsrDataset::Row r1 = data1[i];
+		CsrDataset::Row r4 = data4[i];
+		assert(r1.nnz == r4.nnz);
+		assert(std::equal(r1.indices, r1.indices + r1.nnz, r4.indices));
+		assert(std::equal(r1.values, r1.values + r1.nnz, r4.values));
+		assert(labels1[i] == ((i % 2) ?1.0 :-1.0));
+
+		for(int k = 1; k < r1.nnz; ++k) {assert(r1.indices[k-1] < r1.indices[k]);}
+	}
+
+	//Row 17 has feature 2 moved to its sorted position
+	assert(data1[17].indices[0] == 1 && data1[17].values[0] == 7.5);
+
+	//CSV
+	const char *csvName = "test_ParseSvmFile.csv";
+	{
+		ofstream out(csvName);
+		for(int i = 0; i < 5000; ++i) {
+			out << i << "," << 0.5 * i << "," << (i % 2) << "\n";
+		}
+	}
+
+	vector<VectorXd> dense; vector<double> denseLabels;
+	SVMUtils::readCsvFile(csvName, dense, denseLabels);
+	remove(csvName);
+
+	assert(dense.size() == 5000);
+	for(int i = 0; i < 5000; ++i) {
+		assert(dense[i].size() == 2);
+		assert(dense[i][0] == i && dense[i][1] == 0.5 * i);
+		assert(denseLabels[i] == ((i % 2) ?1.0 :-1.0));
+	}
+
+	return 0;
+}
@@ -29,7 +29,7 @@ int main(int argc, char **argv) {
 	if(Platform::processId == debugProcess)  {Platform::waitForDebugger();}
 	OptOutput out;
 
-	ScheduleType schedules[] = {SCHED_SPIN_DOUBLE, SCHED_SPIN_SINGLE, SCHED_LOCK_FREE};
+	ScheduleType schedules[] = {SCHED_SPIN_DOUBLE, SCHED_SPIN_SINGLE, SCHED_LOCK_FREE, SCHED_MATCHING, SCHED_OPTIMISTIC, SCHED_MCS_DOUBLE};
 
 	for(ScheduleType s : schedules) {
 		try {
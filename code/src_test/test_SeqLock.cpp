@@ -0,0 +1,49 @@
+#include <cmath>
+#include <vector>
+
+#include "core/Platform.h"
+#include "core/SeqLock.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	Platform::init();
+	Platform::setNumLocalThreads(2);
+
+	SeqLockArray seq(4);
+	assert(seq.size() == 4 && seq.version(2) == 0);
+
+	seq.beginWrite(2);
+	assert(seq.version(2) == 1);
+	seq.endWrite(2);
+	assert(seq.version(2) == 2);
+
+	//Pair updates keep values[0] + values[1] constant, so every consistent
+	//snapshot has the same sum
+	vector<double> values = {1.0, 0.0, 0.0, 0.0};
+	int numWrites = 200000;
+	int numBad = 0;
+
+	#pragma omp parallel num_threads(2)
+	{
+		if(Platform::getThreadId() == 0) {
+			for(int k = 0; k < numWrites; ++k) {
+				double moved = (k % 10) * 0.1;
+				seq.beginWrite(0); seq.beginWrite(1);
+				values[0] = 1.0 - moved;
+				values[1] = moved;
+				seq.endWrite(1); seq.endWrite(0);
+			}
+		} else {
+			for(int k = 0; k < numWrites; ++k) {
+				double v0, v1;
+				seq.readPair(values.data(), 0, 1, v0, v1);
+				if(fabs(v0 + v1 - 1.0) > 1e-12) {++numBad;}
+			}
+		}
+	}
+
+	assert(numBad == 0);
+	assert(seq.version(0) == 2u * numWrites && seq.version(1) == 2u * numWrites);
+	return 0;
+}
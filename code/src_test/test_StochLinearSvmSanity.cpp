@@ -16,12 +16,12 @@ int main(int argc, char **argv) {
 	Scheduler *scheduler = new Scheduler(&config);
 	scheduler->setLockingLevel(Scheduler::DOUBLE);
 
-	Dataset data(numExamples);
+	Dataset data;
 
 	for(int i = 0; i < numExamples; ++i) {
-		data[i] = Data(2);
-		data[i].insert(0) = i;
-		data[i].insert(1) = 1.0;
+		int indices[] = {0, 1};
+		double values[] = {1.0 * i, 1.0};
+		data.addRow(indices, values, 2);
 	}
 
 	StochLinearSVMProblem problem(&data, 2, 1e100);
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "problems/CsrDataset.h"
+#include "problems/SVMUtils.h"
+
+using namespace std;
+
+/**
+Writes the cache file, overwrites the bytes at the given offset with value,
+and returns true if mapping the result is rejected.
+*/
+template <typename T>
+bool rejectsPatched(const char *fileName, const CsrDataset &data, const vector<double> &labels,
+		long long offset, T value) {
+	SVMUtils::writeSvmCache(fileName, data, labels);
+	{
+		fstream f(fileName, ios::in | ios::out | ios::binary);
+		f.seekp(offset);
+		f.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	try {
+		CsrDataset mapped; vector<double> mappedLabels; int numFeatures;
+		SVMUtils::mapSvmCache(fileName, mapped, mappedLabels, numFeatures);
+	} catch(FileFormatException &x) {
+		return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char **argv) {
+	const char *fileName = "test_SvmCache.bin";
+	CsrDataset data;
+	vector<double> labels;
+
+	for(int i = 0; i < 100; ++i) {
+		vector<int> indices;
+		vector<double> values;
+
+		for(int k = i % 7; k < 50; k += 1 + i % 5) {
+			indices.push_back(k);
+			values.push_back(0.5 * i - k);
+		}
+
+		data.addRow(indices.data(), values.data(), indices.size());
+		labels.push_back((i % 3) ?1.0 :-1.0);
+	}
+
+	data.setNumFeatures(60);
+	SVMUtils::writeSvmCache(fileName, data, labels);
+
+	CsrDataset mapped; vector<double> mappedLabels; int numFeatures;
+	SVMUtils::mapSvmCache(fileName, mapped, mappedLabels, numFeatures);
+
+	assert(mapped.isAttached());
+	assert(numFeatures == 60);
+	assert(mapped.numFeatures() == 60);
+	assert(mapped.size() == data.size());
+	assert(mapped.nonZeros() == data.nonZeros());
+	assert(mappedLabels == labels);
+
+	for(int i = 0; i < data.size(); ++i) {
+		CsrDataset::Row r1 = data[i];
+		CsrDataset::Row r2 = mapped[i];
+		assert(r1.nnz == r2.nnz);
+		assert(std::equal(r1.indices, r1.indices + r1.nnz, r2.indices));
+		assert(std::equal(r1.values, r1.values + r1.nnz, r2.values));
+	}
+
+	//Copies share the mapping
+	CsrDataset copy = mapped;
+	ASSERT_NEAR(copy[10].dot(copy[20]), data[10].dot(data[20]), 1e-12);
+
+	//Corrupted header is rejected
+	assert(rejectsPatched(fileName, data, labels, 0, 'X'));
+
+	//Counts that are negative, too large or inconsistent with the file are rejected
+	const long long numRowsOffset = 16, numFeaturesOffset = 24, nnzOffset = 32;
+	assert(rejectsPatched(fileName, data, labels, numRowsOffset, -1LL));
+	assert(rejectsPatched(fileName, data, labels, numRowsOffset, 1LL << 40));
+	assert(rejectsPatched(fileName, data, labels, numFeaturesOffset, 1LL << 40));
+	assert(rejectsPatched(fileName, data, labels, nnzOffset, -8LL));
+	assert(rejectsPatched(fileName, data, labels, nnzOffset, (1LL << 62) / sizeof(int)));
+
+	//Row offsets must start at 0, be monotone and end at nnz
+	const long long rowPtrOffset = 64 + 100 * sizeof(double);
+	const long long indicesOffset = rowPtrOffset + 101 * sizeof(long long);
+	assert(rejectsPatched(fileName, data, labels, rowPtrOffset, 1LL));
+	assert(rejectsPatched(fileName, data, labels, rowPtrOffset + 50 * sizeof(long long), -5LL));
+	assert(rejectsPatched(fileName, data, labels, rowPtrOffset + 100 * sizeof(long long), data.nonZeros() - 1));
+
+	//Feature indices must be below numFeatures
+	assert(rejectsPatched(fileName, data, labels, indicesOffset + 4 * sizeof(int), 60));
+	assert(rejectsPatched(fileName, data, labels, indicesOffset, -1));
+
+	//Patching the reserved header words is harmless
+	assert(!rejectsPatched(fileName, data, labels, 40, 0LL));
+
+	remove(fileName);
+	return 0;
+}
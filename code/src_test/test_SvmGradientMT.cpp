@@ -0,0 +1,68 @@
+#include <random>
+#include <vector>
+
+#include "core/Platform.h"
+#include "environments/LocalAsyncScheduler.h"
+#include "environments/LocalMatchingScheduler.h"
+#include "problems/SVMProblem.h"
+
+using namespace std;
+
+typedef LocalAsyncScheduler<SVMInfoSpec> Scheduler;
+
+int main(int argc, char **argv) {
+	const int n = 200;
+	std::mt19937 rng(11);
+	std::normal_distribution<double> noise(0.0, 1.0);
+	vector<double> x0, x1, y;
+
+	for(int i = 0; i < n; ++i) {
+		double label = (i % 2) ?1.0 :-1.0;
+		x0.push_back(label + noise(rng));
+		x1.push_back(0.5 * label + noise(rng));
+		y.push_back(label);
+	}
+
+	Kernel kernel = [&] (int i, int j) -> double {return x0[i] * x0[j] + x1[i] * x1[j] + 1.0;};
+
+	Platform::init();
+	Platform::setNumLocalThreads(4);
+
+	//Default settings with several threads, but F is never recomputed, so any
+	//lost update of F would remain visible at the end
+	SVMProblem problem(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {problem.y(i) = y[i];}
+	problem.setGradientRefreshPeriod(0);
+
+	auto checkF = [&] () {
+		for(int k = 0; k < n; ++k) {
+			double F = 0.0;
+			for(int m = 0; m < n; ++m) {F += problem.alpha(m) * problem.y(m) * kernel(k, m);}
+			ASSERT_NEAR(problem.F(k), F, 1e-9 * (1.0 + fabs(F)));
+		}
+	};
+
+	for(Scheduler::LockingLevel locking : {Scheduler::DOUBLE, Scheduler::SINGLE}) {
+		Scheduler scheduler(n);
+		scheduler.setLockingLevel(locking);
+		scheduler.readProblem(&problem);
+		scheduler.setObjTolerance(0.0);
+		scheduler.setMaxIterations(200000);
+		scheduler.solve();
+		scheduler.deleteNodes();
+		checkF();
+	}
+
+	//Pairs of a round are disjoint, but F is shared, so the matching scheduler
+	//requests atomic updates even when the problem's default is off
+	problem.setAtomicGradientUpdates(false);
+	LocalMatchingScheduler<SVMInfoSpec> matching(n);
+	matching.readProblem(&problem);
+	matching.setObjTolerance(0.0);
+	matching.setMaxIterations(200000);
+	matching.solve();
+	matching.deleteNodes();
+	checkF();
+
+	return 0;
+}
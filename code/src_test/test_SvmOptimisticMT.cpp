@@ -0,0 +1,81 @@
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "core/Platform.h"
+#include "environments/LocalAsyncScheduler.h"
+#include "environments/PairSelectionFunc.h"
+#include "problems/SVMProblem.h"
+
+using namespace std;
+
+typedef LocalAsyncScheduler<SVMInfoSpec> Scheduler;
+
+void makeData(int n, vector<double> &x0, vector<double> &x1, vector<double> &y) {
+	std::mt19937 rng(3);
+	std::normal_distribution<double> noise(0.0, 1.0);
+
+	for(int i = 0; i < n; ++i) {
+		double label = (i % 2) ?1.0 :-1.0;
+		x0.push_back(label + noise(rng));
+		x1.push_back(0.5 * label + noise(rng));
+		y.push_back(label);
+	}
+}
+
+OptOutput solve(SVMProblem &problem, Scheduler::LockingLevel locking) {
+	Scheduler scheduler(problem.numVars());
+	scheduler.setLockingLevel(locking);
+	scheduler.readProblem(&problem);
+	scheduler.setObjTolerance(0.0);
+	scheduler.setMaxIterations(20000);
+	OptOutput output = scheduler.solve();
+	scheduler.deleteNodes();
+	return output;
+}
+
+int main(int argc, char **argv) {
+	const int n = 24;
+	vector<double> x0, x1, y;
+	makeData(n, x0, x1, y);
+
+	//Few variables and threads that give up the CPU in the middle of updates,
+	//so that commits conflict even on a single core
+	Kernel kernel = [&] (int i, int j) -> double {
+		static thread_local int calls = 0;
+		if(++calls % 16 == 0) {std::this_thread::yield();}
+		return x0[i] * x0[j] + x1[i] * x1[j] + 1.0;
+	};
+
+	Platform::init();
+	Platform::setNumLocalThreads(4);
+
+	SVMProblem reference(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {reference.y(i) = y[i];}
+	solve(reference, Scheduler::DOUBLE);
+
+	SVMProblem problem(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {problem.y(i) = y[i];}
+	OptOutput output = solve(problem, Scheduler::OPTIMISTIC);
+
+	LOG("Optimistic retries: " << output.propDouble["optimistic_retries"]);
+	assert(output.propDouble["optimistic_retries"] > 0);
+
+	//Box and equality constraints hold and F matches its definition
+	double sum = 0.0;
+	for(int k = 0; k < n; ++k) {
+		assert(problem.alpha(k) >= 0.0 && problem.alpha(k) <= 1.0);
+		sum += problem.alpha(k) * problem.y(k);
+
+		double F = 0.0;
+		for(int m = 0; m < n; ++m) {F += problem.alpha(m) * problem.y(m) * kernel(k, m);}
+		ASSERT_NEAR(problem.F(k), F, 1e-6 * (1.0 + fabs(F)));
+	}
+
+	ASSERT_NEAR(sum, 0.0, 1e-9);
+
+	double expected = reference.computeExactObjective();
+	LOG("Objective " << problem.computeExactObjective() << " expected " << expected);
+	ASSERT_NEAR(problem.computeExactObjective(), expected, 1e-4 * fabs(expected));
+	return 0;
+}
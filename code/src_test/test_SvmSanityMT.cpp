@@ -50,6 +50,15 @@ int main(int argc, char **argv) {
 		w1 += problem.alpha(i) * problem.y(i);
 	}
 
+	// Check that the incrementally maintained F matches its definition
+	for(int k = 0; k < numExamples; ++k) {
+		double F = 0.0;
+		for(int m = 0; m < numExamples; ++m) {F += problem.alpha(m) * problem.y(m) * kernel(k, m);}
+		ASSERT_NEAR(problem.F(k), F, 1e-6 * (1.0 + fabs(F)));
+	}
+
+	ASSERT_NEAR(problem.computeObjective(), problem.computeExactObjective(), 1e-6);
+
 	problem.computeSVsAndIntercept();
 	LOG(w0 << " " << w1 << " " << problem.b());
 
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "core/Platform.h"
+#include "environments/LocalAsyncScheduler.h"
+#include "environments/LocalMatchingScheduler.h"
+#include "environments/PairSelectionFunc.h"
+#include "problems/SVMProblem.h"
+
+using namespace std;
+
+typedef LocalAsyncScheduler<SVMInfoSpec> Scheduler;
+
+//Noisy two-class problem in the plane, so that many variables end at a bound
+void makeData(int n, vector<double> &x0, vector<double> &x1, vector<double> &y) {
+	std::mt19937 rng(7);
+	std::normal_distribution<double> noise(0.0, 1.0);
+
+	for(int i = 0; i < n; ++i) {
+		double label = (i % 2) ?1.0 :-1.0;
+		x0.push_back(label + noise(rng));
+		x1.push_back(0.5 * label + noise(rng));
+		y.push_back(label);
+	}
+}
+
+int main(int argc, char **argv) {
+	const int n = 300;
+	vector<double> x0, x1, y;
+	makeData(n, x0, x1, y);
+	Kernel kernel = [&] (int i, int j) -> double {return x0[i] * x0[j] + x1[i] * x1[j] + 1.0;};
+
+	Platform::init();
+	Platform::setNumLocalThreads(4);
+
+	//Reference without shrinking, run for a fixed number of updates
+	SVMProblem reference(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {reference.y(i) = y[i];}
+	{
+		Scheduler scheduler(n);
+		scheduler.setLockingLevel(Scheduler::DOUBLE);
+		scheduler.readProblem(&reference);
+		scheduler.setObjTolerance(0.0);
+		scheduler.setMaxIterations(600000);
+		scheduler.solve();
+		scheduler.deleteNodes();
+	}
+
+	//Shrinking with F refreshed after every block, while all threads refresh
+	//their part of F concurrently
+	SVMProblem problem(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {problem.y(i) = y[i];}
+	problem.enableShrinking(5);
+	problem.setGradientRefreshPeriod(1);
+
+	const ActiveSet *activeSet = problem.activeSet();
+	PairSelectionFactory factory = [activeSet] (int threadId, int numThreads) -> PairSelection * {
+		return new ActiveSetPairs(activeSet, threadId);};
+
+	int minActive = n;
+	Scheduler scheduler(factory);
+	scheduler.setLockingLevel(Scheduler::DOUBLE);
+	scheduler.readProblem(&problem);
+	scheduler.setObjTolerance(1e-9);
+	scheduler.setMaxIterations(2000000);
+	scheduler.setListenerIteration([&] (int iteration, int time, double objective) {
+		minActive = std::min(minActive, problem.numActiveVars());});
+	scheduler.solve();
+	scheduler.deleteNodes();
+
+	//Shrinking took effect and was undone before finishing
+	LOG("Smallest active set: " << minActive);
+	assert(minActive < n);
+	assert(problem.numActiveVars() == n);
+
+	//F matches its definition
+	for(int k = 0; k < n; ++k) {
+		double F = 0.0;
+		for(int m = 0; m < n; ++m) {F += problem.alpha(m) * problem.y(m) * kernel(k, m);}
+		ASSERT_NEAR(problem.F(k), F, 1e-6 * (1.0 + fabs(F)));
+	}
+
+	//Same optimum as without shrinking
+	double expected = reference.computeExactObjective();
+	LOG("Objective " << problem.computeExactObjective() << " expected " << expected);
+	ASSERT_NEAR(problem.computeExactObjective(), expected, 1e-3 * fabs(expected));
+
+	//Matchings are drawn over the active variables only
+	SVMProblem matched(n, kernel, 1.0);
+	for(int i = 0; i < n; ++i) {matched.y(i) = y[i];}
+	matched.enableShrinking(5);
+	matched.setGradientRefreshPeriod(1);
+
+	int minMatchedActive = n;
+	LocalMatchingScheduler<SVMInfoSpec> matching(n);
+	matching.readProblem(&matched);
+	matching.setObjTolerance(1e-9);
+	matching.setMaxIterations(2000000);
+	matching.setListenerIteration([&] (int iteration, int time, double objective) {
+		minMatchedActive = std::min(minMatchedActive, matched.numActiveVars());});
+	OptOutput output = matching.solve();
+	matching.deleteNodes();
+
+	LOG("Smallest active set with matchings: " << minMatchedActive);
+	assert(minMatchedActive < n);
+	assert(matched.numActiveVars() == n);
+	assert(output.propDouble["pairs_per_round"] < n / 2);
+	ASSERT_NEAR(matched.computeExactObjective(), expected, 1e-3 * fabs(expected));
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include <vector>
+
+#include "core/Platform.h"
+#include "core/RCDScheduler.h"
+#include "environments/LocalAsyncScheduler.h"
+#include "problems/SVMProblem.h"
+#include "RCDIterationLogger.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	int numExamples = 10;
+	int boundary = 6;
+
+	Platform::init();
+	Platform::setNumLocalThreads(1);
+
+	Kernel kernel = [] (int i, int j) -> double {
+			return (1.0*i*j) + 1.0;};
+
+	//A free variable that is the only candidate of both sets gets a random partner
+	{
+		SVMViolationIndex single(1);
+		double alpha[] = {0.5, 0.0, 0.0, 0.0};
+		double y[] = {1.0, 1.0, -1.0, -1.0};
+		double G[] = {0.0, 10.0, 10.0, 20.0};
+		DualGradient g = [&G] (int t) -> double {return G[t];};
+		single.rebuild(4, 0, alpha, y, 1.0, g);
+		assert(single.numUp() == 1 && single.up(0) == 0);
+		assert(single.numLow() == 1 && single.low(0) == 0);
+
+		for(int order = 0; order < 2; ++order) {
+			MaxViolatingPairs selector(&single, g, kernel, y, 0, 1, order == 1);
+			for(int t = 0; t < 100; ++t) {
+				int i, j, n;
+				selector.getPairs(&i, &j, n);
+				assert(n == 1 && i == 0 && j > 0 && j < 4);
+			}
+		}
+	}
+
+	//Partial rebuilds only evaluate the candidates and a slice, and publish the
+	//gap once a sweep has seen every variable
+	{
+		const int n = 100;
+		vector<double> alpha(n, 0.5), y(n), G(n);
+		for(int t = 0; t < n; ++t) {
+			y[t] = (t % 2) ?1.0 :-1.0;
+			G[t] = 0.01 * ((t * 37) % n);
+		}
+
+		int numEvaluated = 0;
+		DualGradient g = [&] (int t) -> double {++numEvaluated; return G[t];};
+		SVMViolationIndex index(4, 0, 10);
+		index.rebuild(n, 0, alpha.data(), y.data(), 1.0, g);
+		double gap = index.gap();
+		assert(numEvaluated == n && gap > 0.0);
+
+		//Make the last variable by far the most violating for the up set
+		G[n - 1] = -100.0;
+		bool found = false;
+
+		for(int k = 0; k < n / 10; ++k) {
+			numEvaluated = 0;
+			index.rebuild(n, 0, alpha.data(), y.data(), 1.0, g, false);
+			assert(numEvaluated <= 2 * 4 + 10);
+			found = found || index.up(0) == n - 1;
+			if(k < n / 10 - 1) {ASSERT_NEAR(index.gap(), gap, 1e-12);}
+		}
+
+		assert(found && index.up(0) == n - 1);
+		assert(index.gap() > 100.0);
+	}
+
+	SVMProblem problem(numExamples, kernel, 1e100);
+
+	for(int i = 0; i < numExamples; ++i) {
+		problem.y(i) = (i < boundary) ?-1.0 :1.0;
+	}
+
+	//Before any update all positives can go up and all negatives can go down
+	problem.enableWorkingSetSelection(4);
+	const SVMViolationIndex *index = problem.violationIndex();
+	assert(index->numUp() == 4 && index->numLow() == 4);
+	for(int k = 0; k < 4; ++k) {assert(problem.y(index->up(k)) > 0);}
+	for(int k = 0; k < 4; ++k) {assert(problem.y(index->low(k)) < 0);}
+
+	typedef  LocalAsyncScheduler<SVMInfoSpec> Scheduler;
+	DualGradient gradient = [&problem] (int t) -> double {return problem.gradient(t);};
+	const double *labels = &problem.y(0);
+	PairSelectionFactory factory = [=] (int threadId, int numThreads) -> PairSelection * {
+		return new MaxViolatingPairs(index, gradient, kernel, labels, threadId, numThreads, true);};
+
+	Scheduler *scheduler = new Scheduler(factory);
+	scheduler->setLockingLevel(Scheduler::DOUBLE);
+	scheduler->setSyncPeriod(4);
+	scheduler->readProblem(&problem);
+
+	scheduler->setObjTolerance(0.0);
+	scheduler->setMaxIterations(2000);
+	RCDIterationLogger logger("/dev/null", 1);
+	scheduler->setListenerIteration(logger.listenerHandle);
+	scheduler->solve();
+	scheduler->deleteNodes();
+	delete scheduler;
+
+	// Only the boundary points are support vectors
+	for(int i = 0; i < numExamples; ++i) {
+		if(i == boundary - 1 || i == boundary)  {
+			assert(problem.alpha(i) != 0);
+		} else {
+			assert(problem.alpha(i) == 0.0);
+		}
+	}
+
+	ASSERT_NEAR(index->gap(), 0.0, 1e-6);
+
+	//The index is also rebuilt during blocks, and the solver stops on its gap
+	Platform::setNumLocalThreads(4);
+	SVMProblem problem2(numExamples, kernel, 1e100);
+	for(int i = 0; i < numExamples; ++i) {problem2.y(i) = problem.y(i);}
+	problem2.enableWorkingSetSelection(4, 2);
+	const SVMViolationIndex *index2 = problem2.violationIndex();
+	DualGradient gradient2 = [&problem2] (int t) -> double {return problem2.gradient(t);};
+	PairSelectionFactory factory2 = [=] (int threadId, int numThreads) -> PairSelection * {
+		return new MaxViolatingPairs(index2, gradient2, kernel, labels, threadId, numThreads, true);};
+
+	scheduler = new Scheduler(factory2);
+	scheduler->setLockingLevel(Scheduler::DOUBLE);
+	scheduler->setSyncPeriod(100);
+	scheduler->readProblem(&problem2);
+	scheduler->setObjTolerance(1e-6);
+	scheduler->setMaxIterations(1000000);
+	OptOutput out = scheduler->solve();
+	scheduler->deleteNodes();
+	delete scheduler;
+
+	assert(out.numIterations < 1000000);
+	assert(index2->gap() < 1e-6);
+	ASSERT_NEAR(problem2.computeExactObjective(), problem.computeExactObjective(), 1e-6);
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include <sstream>
+#include <string>
+
+#include "core/Platform.h"
+#include "core/TraceRecorder.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	Platform::init();
+	Platform::setNumLocalThreads(2);
+
+	//Detail events may use 15 of 16 slots, the last one is kept for others
+	TraceRecorder trace(2, 16);
+
+	#pragma omp parallel num_threads(2)
+	{
+		for(int k = 0; k < 20; ++k) {
+			TraceScope scope(&trace, "pair_update", k, k + 1, true);
+		}
+
+		TraceScope scope(&trace, "block");
+	}
+
+	assert(trace.numEvents() == 2 * 16);
+	assert(trace.numDropped() == 2 * 5);
+
+	//Null recorders are ignored
+	{TraceScope scope(0, "unused");}
+
+	stringstream out;
+	trace.write(out);
+	string json = out.str();
+
+	assert(json.find("\"dropped_events\":10") != string::npos);
+	assert(json.find("{\"name\":\"block\",\"ph\":\"X\"") != string::npos);
+	assert(json.find("\"args\":{\"i\":3,\"j\":4}") != string::npos);
+	assert(json.find("\"tid\":1") != string::npos);
+	assert(json.find("unused") == string::npos);
+	return 0;
+}